@@ -0,0 +1,73 @@
+// bench_run
+//
+// Runs one of the DrL tools and appends a line of the run_bench.sh
+// results to results_file:
+//
+//   tool,engine,graph,nodes,edges,seconds,nodes_per_sec,edges_per_sec,
+//   peak_rss_kb,energy
+//
+// seconds is the wall time of the command, nodes_per_sec and
+// edges_per_sec are the given graph size over that time, and
+// peak_rss_kb is the peak resident size of the command (kilobytes on
+// Linux).  energy is left empty.  The command's own output goes to
+// stdout as usual.  A failing command stops bench_run with its exit
+// status and nothing is written.
+//
+// Usage: bench_run results_file tool engine graph nodes edges command [args]
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+using namespace std;
+
+int main ( int argc, char **argv )
+{
+
+  if ( argc < 8 )
+  {
+    cout << "Usage: bench_run results_file tool engine graph nodes edges command [args]" << endl;
+    exit (1);
+  }
+  double num_nodes = atof ( argv[5] ), num_edges = atof ( argv[6] );
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now ( );
+  pid_t child = fork ( );
+  if ( child < 0 )
+  {
+    cout << "Error: bench_run could not fork." << endl;
+    exit (1);
+  }
+  if ( child == 0 )
+  {
+    execvp ( argv[7], &argv[7] );
+    cout << "Error: bench_run could not run " << argv[7] << "." << endl;
+    _exit (127);
+  }
+
+  int status;
+  struct rusage usage;
+  if ( wait4 ( child, &status, 0, &usage ) < 0 )
+  {
+    cout << "Error: bench_run lost " << argv[7] << "." << endl;
+    exit (1);
+  }
+  double seconds = chrono::duration<double> ( chrono::steady_clock::now ( ) - start ).count ( );
+  if ( !WIFEXITED ( status ) || WEXITSTATUS ( status ) != 0 )
+  {
+    cout << "Error: " << argv[7] << " failed." << endl;
+    exit ( WIFEXITED ( status ) ? WEXITSTATUS ( status ) : 1 );
+  }
+
+  ofstream results ( argv[1], ios::app );
+  results << argv[2] << "," << argv[3] << "," << argv[4] << "," << argv[5] << ","
+          << argv[6] << "," << seconds << "," << num_nodes/seconds << ","
+          << num_edges/seconds << "," << usage.ru_maxrss << "," << endl;
+
+  return 0;
+}
@@ -0,0 +1,236 @@
+// graph_gen
+//
+// Synthetic weighted graphs for the benchmarks.  The graph is written
+// as root_file.sim (the input of truncate), and with -i also as
+// root_file.int for running layout directly.  Three models are
+// available:
+//
+//   power      Chung-Lu graph with a power-law degree distribution
+//              (exponent 2.5), so a few hubs have very many edges
+//   partition  planted partition: communities of -k nodes, with a
+//              fraction -x of each node's edges leaving its community
+//              (edges inside communities are heavier)
+//   grid       2D lattice with a few extra short range edges, which
+//              lays out as a sheet (little coarsening structure)
+//
+// Graphs depend only on the options and the seed: random numbers come
+// from mt19937_64, used without the library distributions (which may
+// differ between compilers).  Node ids are shuffled, self edges are
+// dropped and duplicate edges merged.
+//
+// Usage: graph_gen [-m model] [-n nodes] [-d degree] [-k size]
+//                  [-x mix] [-s seed] [-i] root_file
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+using namespace std;
+
+static mt19937_64 rng;
+
+// uniform in [0,1)
+static double uniform ( )
+{
+  return ( rng() >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+// uniform in [0,n)
+static long uniform_int ( long n )
+{
+  return (long)( uniform() * n );
+}
+
+// an edge is kept as (lower id << 32 | higher id), so sorting puts
+// duplicates together
+static uint64_t edge_key ( long u, long v )
+{
+  if ( u > v )
+    swap ( u, v );
+  return ( (uint64_t)u << 32 ) | (uint64_t)v;
+}
+
+static void usage ( const char *error_string )
+{
+  cout << endl << "Error: " << error_string << endl << endl
+       << "Usage: graph_gen [options] root_file" << endl << endl
+       << "Writes a synthetic graph to root_file.sim (and root_file.int with -i)." << endl << endl
+       << "Options:" << endl << endl
+       << "\t-m {power,partition,grid} graph model (default power)" << endl
+       << "\t-n {int>=2} number of nodes (default 10000)" << endl
+       << "\t-d {real>0} average degree (default 10)" << endl
+       << "\t-k {int>=2} community size for partition (default 100)" << endl
+       << "\t-x {real[0,1]} fraction of edges between communities (default .1)" << endl
+       << "\t-s {int>=0} random seed (default 0)" << endl
+       << "\t-i also write root_file.int" << endl << endl;
+  exit (1);
+}
+
+int main ( int argc, char **argv )
+{
+
+  string model = "power";
+  long num_nodes = 10000;
+  double degree = 10;
+  long community = 100;
+  double mix = .1;
+  int seed = 0;
+  int int_out = 0;
+
+  if ( argc < 2 )
+    usage ( "not enough arguments!" );
+  for ( int i = 1; i < argc-1; i++ )
+  {
+    string arg = argv[i];
+    if ( arg == "-i" )
+      int_out = 1;
+    else if ( i+1 >= argc-1 )
+      usage ( "flag has no argument." );
+    else if ( arg == "-m" )
+      model = argv[++i];
+    else if ( arg == "-n" )
+      num_nodes = atol ( argv[++i] );
+    else if ( arg == "-d" )
+      degree = atof ( argv[++i] );
+    else if ( arg == "-k" )
+      community = atol ( argv[++i] );
+    else if ( arg == "-x" )
+      mix = atof ( argv[++i] );
+    else if ( arg == "-s" )
+      seed = atoi ( argv[++i] );
+    else
+      usage ( "unrecognized option!" );
+  }
+  if ( model != "power" && model != "partition" && model != "grid" )
+    usage ( "model must be power, partition or grid." );
+  if ( num_nodes < 2 || num_nodes > 2000000000 )
+    usage ( "number of nodes must be from 2 to 2e9." );
+  if ( degree <= 0 )
+    usage ( "average degree must be > 0." );
+  if ( community < 2 || community > num_nodes )
+    usage ( "community size must be from 2 to the number of nodes." );
+  if ( mix < 0 || mix > 1 )
+    usage ( "mix must be between 0 and 1." );
+  if ( seed < 0 )
+    usage ( "random seed must be >= 0." );
+
+  string root = argv[argc-1];
+  rng.seed ( seed );
+
+  long num_edges = (long)( num_nodes*degree/2 );
+  vector<uint64_t> edges;
+  edges.reserve ( num_edges );
+
+  cout << "Generating " << model << " graph with " << num_nodes << " nodes ..." << endl;
+
+  if ( model == "power" )
+  {
+    // expected degree of node i is proportional to (i+1)^(-1/(2.5-1));
+    // both ends of each edge are drawn from these weights
+    vector<double> cumulative ( num_nodes );
+    double total = 0;
+    for ( long i = 0; i < num_nodes; i++ )
+    {
+      total += pow ( (double)(i+1), -1.0/1.5 );
+      cumulative[i] = total;
+    }
+    for ( long e = 0; e < num_edges; e++ )
+    {
+      long u = lower_bound ( cumulative.begin(), cumulative.end(), uniform()*total ) - cumulative.begin();
+      long v = lower_bound ( cumulative.begin(), cumulative.end(), uniform()*total ) - cumulative.begin();
+      if ( u != v && u < num_nodes && v < num_nodes )
+        edges.push_back ( edge_key ( u, v ) );
+    }
+  }
+  else if ( model == "partition" )
+  {
+    // communities are runs of community ids (before shuffling)
+    for ( long e = 0; e < num_edges; e++ )
+    {
+      long u = uniform_int ( num_nodes ), v;
+      if ( uniform() < mix )
+        v = uniform_int ( num_nodes );
+      else
+      {
+        long first = u / community * community;
+        v = first + uniform_int ( min ( community, num_nodes - first ) );
+      }
+      if ( u != v )
+        edges.push_back ( edge_key ( u, v ) );
+    }
+  }
+  else
+  {
+    // lattice edges (degree 4), then short range extras up to degree
+    long side = (long)ceil ( sqrt ( (double)num_nodes ) );
+    for ( long u = 0; u < num_nodes; u++ )
+    {
+      if ( (u+1) % side != 0 && u+1 < num_nodes )
+        edges.push_back ( edge_key ( u, u+1 ) );
+      if ( u+side < num_nodes )
+        edges.push_back ( edge_key ( u, u+side ) );
+    }
+    for ( long e = 2*num_nodes; e < num_edges; e++ )
+    {
+      long u = uniform_int ( num_nodes );
+      long v = u + ( uniform_int ( 7 ) - 3 ) + side*( uniform_int ( 7 ) - 3 );
+      if ( u != v && v >= 0 && v < num_nodes )
+        edges.push_back ( edge_key ( u, v ) );
+    }
+  }
+
+  sort ( edges.begin(), edges.end() );
+  edges.erase ( unique ( edges.begin(), edges.end() ), edges.end() );
+
+  // shuffle ids, so id order says nothing about the structure
+  vector<long> label ( num_nodes );
+  for ( long i = 0; i < num_nodes; i++ )
+    label[i] = i;
+  for ( long i = num_nodes-1; i > 0; i-- )
+    swap ( label[i], label[uniform_int ( i+1 )] );
+
+  // write .sim (and .int); weights are in (0,1], heavier inside
+  // partition communities
+  ofstream sim_out ( (root + ".sim").c_str() );
+  ofstream int_file;
+  if ( int_out )
+    int_file.open ( (root + ".int").c_str() );
+  if ( !sim_out || ( int_out && !int_file ) )
+  {
+    cout << "Error: could not open output files for " << root << "." << endl;
+    exit (1);
+  }
+
+  vector<char> present ( num_nodes, 0 );
+  for ( unsigned long e = 0; e < edges.size(); e++ )
+  {
+    long u = (long)( edges[e] >> 32 ), v = (long)( edges[e] & 0xffffffff );
+    float weight = 1 - uniform();
+    if ( model == "partition" )
+      weight = ( u / community == v / community ) ? .5 + weight/2 : weight/2;
+    present[u] = present[v] = 1;
+
+    sim_out << label[u] << "\t" << label[v] << "\t" << weight << "\n";
+    if ( int_out )
+      int_file << label[u] << "\t" << label[v] << "\t" << weight << "\n";
+  }
+  sim_out.close ();
+  if ( int_out )
+    int_file.close ();
+
+  long num_present = 0;
+  for ( long i = 0; i < num_nodes; i++ )
+    num_present += present[i];
+
+  // (run_bench.sh reads this line)
+  cout << "Wrote " << num_present << " nodes and " << edges.size() << " edges to "
+       << root << ".sim." << endl;
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+// layout_bench
+//
+// Times a layout of root_file.int with the layout library and appends
+// one line to a results file (or prints it), in the columns of
+// run_bench.sh:
+//
+//   tool,engine,graph,nodes,edges,seconds,nodes_per_sec,edges_per_sec,
+//   peak_rss_kb,energy
+//
+// For layout, nodes_per_sec and edges_per_sec count node moves and
+// edge visits: nodes (edges) times iterations, over the time taken by
+// run (reading the graph is not timed).  energy is get_tot_energy at
+// the end of the layout, and peak_rss_kb the largest peak resident
+// size of any proc.  Built with the MPI configuration, it runs the
+// MPI engine under mpirun.
+//
+// Usage: layout_bench [-t threads] [-b block] [-q theta] [-g grid]
+//                     [-e] [-o results_file] root_file
+//
+// -e writes root_file.icoord and root_file.iedges, as layout -e does.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <sys/resource.h>
+
+using namespace std;
+
+#include <liblayout.h>
+#ifdef MUSE_MPI
+  #include <mpi.h>
+#endif
+
+static void usage ( const char *error_string )
+{
+  cout << endl << "Error: " << error_string << endl << endl
+       << "Usage: layout_bench [-t threads] [-b block] [-q theta] [-g grid]" << endl
+       << "                    [-e] [-o results_file] root_file" << endl << endl;
+  #ifdef MUSE_MPI
+    MPI_Abort ( MPI_COMM_WORLD, 1 );
+  #else
+    exit (1);
+  #endif
+}
+
+// layout callback keeping the number of iterations done
+
+static bool count_iterations ( drl_layout &, int iteration, void *user_data )
+{
+  *(int *)user_data = iteration;
+  return true;
+}
+
+int main ( int argc, char **argv )
+{
+
+  int myid = 0, num_procs = 1;
+  #ifdef MUSE_MPI
+    MPI_Init ( &argc, &argv );
+    MPI_Comm_size ( MPI_COMM_WORLD, &num_procs );
+    MPI_Comm_rank ( MPI_COMM_WORLD, &myid );
+  #endif
+
+  // every proc. parses the (same) command line
+  layout_options options;
+  options.proc_id = myid;
+  options.num_procs = num_procs;
+  int edges_out = 0;
+  string results_file;
+
+  if ( argc < 2 )
+    usage ( "not enough arguments!" );
+  for ( int i = 1; i < argc-1; i++ )
+  {
+    string arg = argv[i];
+    if ( arg == "-e" )
+      edges_out = 1;
+    else if ( i+1 >= argc-1 )
+      usage ( "flag has no argument." );
+    else if ( arg == "-t" )
+      options.num_threads = atoi ( argv[++i] );
+    else if ( arg == "-b" )
+      options.block_size = atoi ( argv[++i] );
+    else if ( arg == "-q" )
+      options.theta = atof ( argv[++i] );
+    else if ( arg == "-g" )
+      options.grid_size = atoi ( argv[++i] );
+    else if ( arg == "-o" )
+      results_file = argv[++i];
+    else
+      usage ( "unrecognized option!" );
+  }
+  if ( options.num_threads < 1 || options.block_size < 1 || options.theta < 0 ||
+       options.grid_size < 0 )
+    usage ( "bad option value." );
+  if ( options.num_threads > 1 && num_procs > 1 )
+    usage ( "-t cannot be used with more than one MPI process." );
+
+  string root = argv[argc-1];
+  drl_layout layout ( (root + ".int").c_str(), options );
+
+  // (each edge is held at both ends, split over the procs)
+  long num_edges = layout.num_edges ( ), num_nodes = layout.num_nodes ( );
+  #ifdef MUSE_MPI
+    long local_edges = num_edges;
+    MPI_Allreduce ( &local_edges, &num_edges, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD );
+  #endif
+  num_edges /= 2;
+
+  int iterations = 0;
+  layout.set_callback ( count_iterations, &iterations );
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now ( );
+  layout.run ( );
+  double seconds = chrono::duration<double> ( chrono::steady_clock::now ( ) - start ).count ( );
+  float energy = layout.get_tot_energy ( );
+
+  if ( edges_out )
+  {
+    for ( int i = 0; i < num_procs; i++ )
+    {
+      if ( myid == i )
+        layout.write_sim ( (root + ".icoord").c_str() );
+      #ifdef MUSE_MPI
+        MPI_Barrier ( MPI_COMM_WORLD );
+      #endif
+    }
+    if ( myid == 0 )
+      layout.write_coord ( (root + ".icoord").c_str() );
+  }
+
+  // peak resident size (kilobytes on Linux) of the largest proc.
+  struct rusage usage;
+  getrusage ( RUSAGE_SELF, &usage );
+  long peak_rss = usage.ru_maxrss;
+  #ifdef MUSE_MPI
+    long local_rss = peak_rss;
+    MPI_Reduce ( &local_rss, &peak_rss, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD );
+  #endif
+
+  if ( myid == 0 )
+  {
+    ostringstream engine;
+    if ( num_procs > 1 )
+      engine << "mpi" << num_procs;
+    else if ( options.num_threads > 1 )
+      engine << "threads" << options.num_threads;
+    else
+      engine << "serial";
+    if ( options.block_size > 1 )
+      engine << "_b" << options.block_size;
+    if ( options.theta > 0 )
+      engine << "_q" << options.theta;
+
+    string graph_name = root.substr ( root.find_last_of ( '/' ) + 1 );
+    ostringstream line;
+    line << "layout," << engine.str() << "," << graph_name << "," << num_nodes << ","
+         << num_edges << "," << seconds << "," << num_nodes*(double)iterations/seconds << ","
+         << num_edges*(double)iterations/seconds << "," << peak_rss << "," << energy;
+
+    if ( results_file.empty() )
+      cout << line.str() << endl;
+    else
+    {
+      ofstream results ( results_file.c_str(), ios::app );
+      results << line.str() << endl;
+    }
+  }
+
+  #ifdef MUSE_MPI
+    MPI_Finalize ();
+  #endif
+
+  return 0;
+}
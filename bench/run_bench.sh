@@ -0,0 +1,99 @@
+#!/bin/bash
+
+# This is a shell script to run the DrL benchmarks.  Synthetic graphs
+# are made once by graph_gen (in DATADIR), then truncate, layout
+# (serial, threaded and MPI), average_link and coarsen are run on each
+# graph.  One line per run is appended to RESULTS, with columns
+#
+#   tool,engine,graph,nodes,edges,seconds,nodes_per_sec,edges_per_sec,
+#   peak_rss_kb,energy
+#
+# (see layout_bench.cpp and bench_run.cpp for what is timed).  The
+# output of the tools goes to DATADIR/bench.log.
+#
+# Build the tools first: make in ../src, then make in this directory.
+# For MPI layout runs, set MPI_PROCS and MPIBIN to where a
+# layout_bench built with the parallel Configuration.mk is.
+#
+# The variables below can also be set in the environment, e.g.
+#
+#   SIZES="1000000 10000000" MODELS=power THREADS=8 ./run_bench.sh
+
+cd "$(dirname "$0")"
+
+BINDIR=${BINDIR:-../bin}				# DrL bin directory
+DATADIR=${DATADIR:-./data}				# generated graphs and outputs
+RESULTS=${RESULTS:-./results.csv}		# results (appended)
+
+# graphs
+MODELS=${MODELS:-"power partition grid"}	# graph_gen models
+SIZES=${SIZES:-"10000 100000"}			# nodes (10000 to 10000000)
+DEGREE=${DEGREE:-10}					# average degree
+SEED=${SEED:-0}							# graph_gen seed
+
+# engines
+THREADS=${THREADS:-4}				# threads for a threaded layout (1 to skip)
+MPI_PROCS=${MPI_PROCS:-0}			# procs for MPI layouts (0 to skip)
+MPIRUN=${MPIRUN:-mpirun}			# MPI launcher
+MPIBIN=${MPIBIN:-$BINDIR}			# bin directory of the MPI layout_bench
+BLOCK=${BLOCK:-16}					# -b for a second MPI layout (1 to skip)
+
+# tools
+TRUNCATE_LINKS=${TRUNCATE_LINKS:-10}	# truncate -t
+
+mkdir -p $DATADIR
+LOG=$DATADIR/bench.log
+if [ ! -f $RESULTS ]
+then
+  echo "tool,engine,graph,nodes,edges,seconds,nodes_per_sec,edges_per_sec,peak_rss_kb,energy" > $RESULTS
+fi
+
+for MODEL in $MODELS
+do
+  for SIZE in $SIZES
+  do
+
+    NAME=$MODEL"_"$SIZE
+    ROOT=$DATADIR/$NAME
+
+    # graphs are kept between runs (delete DATADIR to remake them)
+    if [ ! -f $ROOT.gen ] || [ ! -f $ROOT.sim ]
+    then
+      echo "----- GENERATING $NAME -----"
+      $BINDIR/graph_gen -m $MODEL -n $SIZE -d $DEGREE -s $SEED $ROOT > $ROOT.gen || exit 1
+    fi
+    NODES=`awk '/^Wrote/ {print $2}' $ROOT.gen`
+    EDGES=`awk '/^Wrote/ {print $5}' $ROOT.gen`
+
+    echo "----- $NAME: truncate -----"
+    $BINDIR/bench_run $RESULTS truncate serial $NAME $NODES $EDGES \
+      $BINDIR/truncate -t $TRUNCATE_LINKS $ROOT >> $LOG || exit 1
+
+    echo "----- $NAME: layout -----"
+    $BINDIR/layout_bench -e -o $RESULTS $ROOT >> $LOG || exit 1
+    if [ $THREADS -gt 1 ]
+    then
+      $BINDIR/layout_bench -t $THREADS -o $RESULTS $ROOT >> $LOG || exit 1
+    fi
+    if [ $MPI_PROCS -gt 0 ]
+    then
+      $MPIRUN -np $MPI_PROCS $MPIBIN/layout_bench -o $RESULTS $ROOT >> $LOG || exit 1
+      if [ $BLOCK -gt 1 ]
+      then
+        $MPIRUN -np $MPI_PROCS $MPIBIN/layout_bench -b $BLOCK -o $RESULTS $ROOT >> $LOG || exit 1
+      fi
+    fi
+
+    # (average_link uses the .icoord and .iedges of the serial layout)
+    echo "----- $NAME: average_link -----"
+    $BINDIR/bench_run $RESULTS average_link serial $NAME $NODES $EDGES \
+      $BINDIR/average_link $ROOT >> $LOG || exit 1
+
+    echo "----- $NAME: coarsen -----"
+    $BINDIR/bench_run $RESULTS coarsen serial $NAME $NODES $EDGES \
+      $BINDIR/coarsen -l 2 $ROOT >> $LOG || exit 1
+
+  done
+done
+
+echo "----- BENCHMARKS COMPLETE (results in $RESULTS) -----"
@@ -0,0 +1,168 @@
+// stamp_bench
+//
+// Microbenchmark for the coarse density stamping kernels in
+// DensityGrid.  A cloud of nodes is moved around the grid the way
+// update_density does it (subtract the old stamp, add the new one)
+// using
+//
+//   1. the original scalar pointer walk (copied here for reference),
+//   2. DensityGrid::Subtract followed by DensityGrid::Add,
+//   3. DensityGrid::Move, which fuses the two stamps,
+//
+// for a range of step lengths, from early-schedule jumps down to the
+// sub-cell jitter typical of the cooldown and simmer stages.
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+
+using namespace std;
+
+#include <DensityGrid.h>
+
+// grid used for all three versions (the old compile time default)
+#define GRID_SIZE 1000
+#define HALF_VIEW 2000
+
+// the original Subtract/Add loops
+static void scalar_stamp ( float (*Density)[GRID_SIZE], float (*fall_off)[RADIUS*2+1],
+						   float x, float y, float sign )
+{
+  int x_grid, y_grid, diam;
+  float *den_ptr, *fall_ptr;
+
+  x_grid = (int)((x+HALF_VIEW+.5)*VIEW_TO_GRID) - RADIUS;
+  y_grid = (int)((y+HALF_VIEW+.5)*VIEW_TO_GRID) - RADIUS;
+  diam = 2*RADIUS;
+
+  den_ptr = &Density[y_grid][x_grid];
+  fall_ptr = &fall_off[0][0];
+  if ( sign > 0 )
+    for(int i = 0; i <= diam; i++) {
+      for(int j = 0; j <= diam; j++)
+	    *den_ptr++ += *fall_ptr++;
+      den_ptr += GRID_SIZE - (diam+1);
+    }
+  else
+    for(int i = 0; i <= diam; i++) {
+      for(int j = 0; j <= diam; j++)
+	    *den_ptr++ -= *fall_ptr++;
+      den_ptr += GRID_SIZE - (diam+1);
+    }
+}
+
+static double seconds_since ( chrono::steady_clock::time_point start )
+{
+  return chrono::duration<double> ( chrono::steady_clock::now() - start ).count();
+}
+
+int main ( int argc, char **argv )
+{
+
+  int num_nodes = 100000;
+  int num_sweeps = 20;
+  if ( argc > 1 ) num_nodes = atoi ( argv[1] );
+  if ( argc > 2 ) num_sweeps = atoi ( argv[2] );
+
+  float (*Density)[GRID_SIZE] = new float[GRID_SIZE][GRID_SIZE];
+  float (*fall_off)[RADIUS*2+1] = new float[RADIUS*2+1][RADIUS*2+1];
+  for ( int i = 0; i < GRID_SIZE; i++ )
+    for ( int j = 0; j < GRID_SIZE; j++ )
+      Density[i][j] = 0;
+  for ( int i = -RADIUS; i <= RADIUS; i++ )
+    for ( int j = -RADIUS; j <= RADIUS; j++ )
+      fall_off[i+RADIUS][j+RADIUS] = (float)((RADIUS-abs(i))/(float)RADIUS) *
+	                                 (float)((RADIUS-abs(j))/(float)RADIUS);
+
+  DensityGrid separate, fused;
+  separate.Init ( num_nodes, GRID_SIZE );
+  fused.Init ( num_nodes, GRID_SIZE );
+
+  cout << "stamp_bench: " << num_nodes << " nodes, " << num_sweeps << " sweeps" << endl;
+  #if defined(__AVX__)
+    cout << "kernels: AVX" << endl;
+  #elif defined(__SSE__)
+    cout << "kernels: SSE" << endl;
+  #else
+    cout << "kernels: scalar" << endl;
+  #endif
+  cout << "step\tscalar(ns)\tsub+add(ns)\tmove(ns)" << endl;
+
+  float steps[] = { 200.0, 20.0, 2.0, 0.5 };
+  for ( unsigned int s = 0; s < sizeof(steps)/sizeof(float); s++ )
+  {
+
+    // place nodes and fix a random walk so all three versions
+    // see the same moves
+    srand ( 1 );
+    vector<Node> nodes;
+    for ( int i = 0; i < num_nodes; i++ )
+    {
+      Node n ( i );
+      n.x = n.sub_x = 1000.0 * ( rand()/(float)RAND_MAX - .5 );
+      n.y = n.sub_y = 1000.0 * ( rand()/(float)RAND_MAX - .5 );
+      nodes.push_back ( n );
+      scalar_stamp ( Density, fall_off, n.x, n.y, 1 );
+      separate.Add ( nodes[i], false );
+      fused.Add ( nodes[i], false );
+    }
+    vector<float> walk ( 2*num_nodes*num_sweeps );
+    for ( unsigned int i = 0; i < walk.size(); i++ )
+      walk[i] = steps[s] * ( rand()/(float)RAND_MAX - .5 );
+
+    vector<Node> a ( nodes ), b ( nodes ), c ( nodes );
+    double t_scalar, t_separate, t_fused;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for ( int k = 0, w = 0; k < num_sweeps; k++ )
+      for ( int i = 0; i < num_nodes; i++, w += 2 )
+      {
+        scalar_stamp ( Density, fall_off, a[i].sub_x, a[i].sub_y, -1 );
+        a[i].x += walk[w];
+        a[i].y += walk[w+1];
+        scalar_stamp ( Density, fall_off, a[i].x, a[i].y, 1 );
+        a[i].sub_x = a[i].x;
+        a[i].sub_y = a[i].y;
+      }
+    t_scalar = seconds_since ( start );
+
+    start = chrono::steady_clock::now();
+    for ( int k = 0, w = 0; k < num_sweeps; k++ )
+      for ( int i = 0; i < num_nodes; i++, w += 2 )
+      {
+        b[i].x += walk[w];
+        b[i].y += walk[w+1];
+        separate.Subtract ( b[i], false, false, false );
+        separate.Add ( b[i], false );
+      }
+    t_separate = seconds_since ( start );
+
+    start = chrono::steady_clock::now();
+    for ( int k = 0, w = 0; k < num_sweeps; k++ )
+      for ( int i = 0; i < num_nodes; i++, w += 2 )
+      {
+        c[i].x += walk[w];
+        c[i].y += walk[w+1];
+        fused.Move ( c[i], false, false, false );
+      }
+    t_fused = seconds_since ( start );
+
+    double moves = (double)num_nodes*num_sweeps;
+    cout << steps[s] << "\t" << 1e9*t_scalar/moves << "\t\t"
+         << 1e9*t_separate/moves << "\t\t" << 1e9*t_fused/moves << endl;
+
+    // reset grids for the next step length
+    for ( int i = 0; i < num_nodes; i++ )
+    {
+      scalar_stamp ( Density, fall_off, a[i].sub_x, a[i].sub_y, -1 );
+      separate.Subtract ( b[i], false, false, false );
+      fused.Subtract ( c[i], false, false, false );
+    }
+  }
+
+  delete[] Density;
+  delete[] fall_off;
+  return 0;
+}
@@ -26,6 +26,8 @@ BINDIR=../../bin				# regular bin directory
 # general inputs
 ROOTNAME=yeast				# root name of project
 MEMORY=1				# use multiple scans to conserve memory
+BINARY=0				# write binary .full and .int files (full precision
+					# weights, so the layout differs from BINARY=0)
 
 # initial layout & clustering
 TRUNCATE_LINKS=10	# initial truncation number of edges
@@ -48,6 +50,13 @@ FINAL_CUT=.5		# final edge cut
 
 # calls start here:
 
+# truncate and coarsen write binary files with -b
+BINFLAG=""
+if [ $BINARY -eq 1 ]
+then
+  BINFLAG="-b"
+fi
+
 if [ $STARTLEVEL -eq 1 ]
 then
 
@@ -64,11 +73,11 @@ then
   echo "----- INITIAL TRUNCATION -----"
   if [ $INIT_NORM -eq 0 ]
   then
-    echo $BINDIR"/truncate -t" $TRUNCATE_LINKS "-m" $MEMORY $ROOTNAME
-    $BINDIR/truncate -t $TRUNCATE_LINKS -m $MEMORY $ROOTNAME
+    echo $BINDIR"/truncate -t" $TRUNCATE_LINKS "-m" $MEMORY $BINFLAG $ROOTNAME
+    $BINDIR/truncate -t $TRUNCATE_LINKS -m $MEMORY $BINFLAG $ROOTNAME
   else
-    echo $BINDIR"truncate -n -t" $TRUNCATE_LINKS "-m" $MEMORY $ROOTNAME
-    $BINDIR/truncate -n -t $TRUNCATE_LINKS -m $MEMORY $ROOTNAME
+    echo $BINDIR"truncate -n -t" $TRUNCATE_LINKS "-m" $MEMORY $BINFLAG $ROOTNAME
+    $BINDIR/truncate -n -t $TRUNCATE_LINKS -m $MEMORY $BINFLAG $ROOTNAME
   fi
 
   # copy the .int file to .coarse_int
@@ -146,11 +155,11 @@ do
   # now we coarsen
   if [ $NORMALIZE -eq 0 ]
   then
-    echo $BINDIR"/coarsen -l" $LEVEL "-m" $MEMORY $ROOTNAME
-    $BINDIR/coarsen -l $LEVEL -m $MEMORY $ROOTNAME
+    echo $BINDIR"/coarsen -l" $LEVEL "-m" $MEMORY $BINFLAG $ROOTNAME
+    $BINDIR/coarsen -l $LEVEL -m $MEMORY $BINFLAG $ROOTNAME
   else
-    echo $BINDIR"/coarsen -l" $LEVEL "-n -m" $MEMORY $ROOTNAME
-    $BINDIR/coarsen -l $LEVEL -n -m $MEMORY $ROOTNAME
+    echo $BINDIR"/coarsen -l" $LEVEL "-n -m" $MEMORY $BINFLAG $ROOTNAME
+    $BINDIR/coarsen -l $LEVEL -n -m $MEMORY $BINFLAG $ROOTNAME
   fi
 
   # save .int files to .coarse_int for later
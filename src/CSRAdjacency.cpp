@@ -0,0 +1,121 @@
+// This file contains the member definitions of the CSRAdjacency.h class
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include <CSRAdjacency.h>
+#include <Checkpoint.h>
+
+// entry used to sort a single row by target index, remembering
+// the order the edge was read so the last duplicate wins (as it
+// did with map::operator[])
+
+struct csr_entry {
+	int col;
+	long seq;
+	float w;
+};
+
+static bool csr_entry_less ( const csr_entry &a, const csr_entry &b )
+{
+	if ( a.col != b.col ) return a.col < b.col;
+	return a.seq < b.seq;
+}
+
+// Build takes a list of (row, col, weight) triples and produces
+// the compressed rows.  The triple vectors are released as we go
+// to keep peak memory down on large graphs.
+
+void CSRAdjacency::Build ( int num_rows, vector<int> &rows, vector<int> &cols,
+						   vector<float> &weights )
+{
+
+	long num_entries = rows.size();
+
+	// count entries in each row
+	offset.assign ( num_rows + 1, 0 );
+	for ( long i = 0; i < num_entries; i++ )
+		offset[rows[i]+1]++;
+	for ( int r = 0; r < num_rows; r++ )
+		offset[r+1] += offset[r];
+
+	// stable counting sort of triples into rows (file order is
+	// preserved within each row)
+	vector<long> fill ( offset.begin(), offset.end()-1 );
+	vector<long> order ( num_entries );
+	for ( long i = 0; i < num_entries; i++ )
+		order[fill[rows[i]]++] = i;
+	vector<int>().swap ( rows );
+	vector<long>().swap ( fill );
+
+	target.resize ( num_entries );
+	weight.resize ( num_entries );
+	degree.assign ( num_rows, 0 );
+
+	// sort each row by target, dropping duplicate edges
+	vector<csr_entry> row_entries;
+	for ( int r = 0; r < num_rows; r++ )
+	{
+		row_entries.clear ();
+		for ( long i = offset[r]; i < offset[r+1]; i++ )
+		{
+			csr_entry e;
+			e.col = cols[order[i]];
+			e.seq = order[i];
+			e.w = weights[order[i]];
+			row_entries.push_back ( e );
+		}
+		sort ( row_entries.begin(), row_entries.end(), csr_entry_less );
+
+		long out = offset[r];
+		for ( unsigned int j = 0; j < row_entries.size(); j++ )
+		{
+			if ( (j+1 < row_entries.size()) && (row_entries[j+1].col == row_entries[j].col) )
+				continue;
+			target[out] = row_entries[j].col;
+			weight[out] = row_entries[j].w;
+			out++;
+		}
+		degree[r] = (int)(out - offset[r]);
+	}
+
+	vector<int>().swap ( cols );
+	vector<float>().swap ( weights );
+}
+
+// Cut removes the k-th live neighbor of row by sliding the rest of
+// the row down one slot.  Rows are short compared to the graph, so
+// this is much cheaper than the tree rebalance map::erase did.
+
+void CSRAdjacency::Cut ( int row, int k )
+{
+	long start = offset[row];
+	int last = degree[row] - 1;
+	for ( int j = k; j < last; j++ )
+	{
+		target[start+j] = target[start+j+1];
+		weight[start+j] = weight[start+j+1];
+	}
+	degree[row] = last;
+}
+
+// Write and Read save the rows as they stand, cut edges included
+// (the gaps left by Cut are saved too, so offsets are unchanged)
+
+void CSRAdjacency::Write ( ostream &out ) const
+{
+	write_vector ( out, offset );
+	write_vector ( out, degree );
+	write_vector ( out, target );
+	write_vector ( out, weight );
+}
+
+bool CSRAdjacency::Read ( istream &in )
+{
+	if ( !read_vector ( in, offset ) || !read_vector ( in, degree ) ||
+		 !read_vector ( in, target ) || !read_vector ( in, weight ) )
+		return false;
+	return ( offset.size() == degree.size() + 1 ) && ( target.size() == weight.size() );
+}
@@ -0,0 +1,45 @@
+#ifndef __CSR_ADJACENCY_H__
+#define __CSR_ADJACENCY_H__
+
+// The CSRAdjacency class stores the weighted neighbors of each node
+// in compressed sparse row form: an offset into contiguous target and
+// weight arrays for each row.  Neighbors within a row are kept sorted
+// by target index (the same order the old map<int, map<int,float> >
+// gave us) so energy sums are unchanged.  Edge cutting compacts the
+// row in place and shrinks its degree, so cut edges leave a gap at
+// the end of the row which is never visited again.
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+class CSRAdjacency {
+
+public:
+
+	// Methods
+	void Build ( int num_rows, vector<int> &rows, vector<int> &cols,
+				 vector<float> &weights );
+	void Cut ( int row, int k );
+	void Write ( ostream &out ) const;		// (checkpoints)
+	bool Read ( istream &in );
+
+	int Num_Rows ( ) const { return (int)degree.size(); }
+	int Degree ( int row ) const { return degree[row]; }
+	const int *Targets ( int row ) const { return target.data() + offset[row]; }
+	const float *Weights ( int row ) const { return weight.data() + offset[row]; }
+
+	// Con/Decon
+	CSRAdjacency ( ) { }
+	~CSRAdjacency ( ) { }
+
+private:
+
+	vector<long> offset;		// start of each row in target/weight
+	vector<int> degree;			// live neighbors in each row (<= capacity)
+	vector<int> target;			// neighbor indices, row by row
+	vector<float> weight;		// edge weights, parallel to target
+};
+
+#endif // __CSR_ADJACENCY_H__
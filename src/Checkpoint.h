@@ -0,0 +1,76 @@
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+// Checkpoint files hold the state of a layout between iterations, so
+// a layout can be stopped and resumed (layout -k and --resume).  Each
+// proc. writes its own file, laid out as
+//
+//	CheckpointHeader	magic, version, procs and nodes
+//	graph state			schedule, positions, neighbors (graph.cpp)
+//	density state		DensityGrid or DensityTree
+//
+// Values and arrays are written as raw bytes, in the byte order of
+// the machine, so a checkpoint should be resumed by the same build.
+// An array is written as its length (int64) then its entries.
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+#define CHECKPOINT_MAGIC "DrLchk"	// 8 bytes, including terminating 0
+#define CHECKPOINT_VERSION 3
+
+struct CheckpointHeader {
+	char magic[8];
+	int32_t version;
+	int32_t num_procs;
+	int32_t proc_id;
+	int32_t num_nodes;
+};
+
+template <class T> inline void write_value ( ostream &out, const T &value )
+{
+	out.write ( (const char *)&value, sizeof(T) );
+}
+
+template <class T> inline bool read_value ( istream &in, T &value )
+{
+	in.read ( (char *)&value, sizeof(T) );
+	return (bool)in;
+}
+
+template <class T> inline void write_vector ( ostream &out, const vector<T> &values )
+{
+	int64_t length = values.size();
+	write_value ( out, length );
+	if ( length > 0 )
+	  out.write ( (const char *)values.data(), length*sizeof(T) );
+}
+
+template <class T> inline bool read_vector ( istream &in, vector<T> &values )
+{
+	int64_t length;
+	if ( !read_value ( in, length ) || length < 0 )
+	  return false;
+	values.resize ( length );
+	if ( length > 0 )
+	  in.read ( (char *)values.data(), length*sizeof(T) );
+	return (bool)in;
+}
+
+// read_array reads an array which must have the given length into
+// existing storage
+
+template <class T> inline bool read_array ( istream &in, T *values, int64_t length )
+{
+	int64_t saved_length;
+	if ( !read_value ( in, saved_length ) || saved_length != length )
+	  return false;
+	if ( length > 0 )
+	  in.read ( (char *)values, length*sizeof(T) );
+	return (bool)in;
+}
+
+#endif // __CHECKPOINT_H__
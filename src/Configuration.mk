@@ -32,10 +32,12 @@ CPP         = g++     # C++ Compiler
 CC          = gcc     # C compiler
 AR          = ar
 INC         = -I$(ALL_DIR) -I$(MATH_DIR)
+THREAD      = -pthread
+SIMD        = #-mavx2	# density stamping kernels use SSE by default on x86-64
 DBUG        = #-g -Wall -pedantic -g #-DDEBUG #-ansi
 OPT         = -O3
-CFLAGS      = $(OPT) $(MOVIE) $(DBUG) $(INC) $(GSLC) $(LIBGAC) -c
-LFLAGS      = $(OPT) $(GSLL) $(LIBGAL)
+CFLAGS      = $(OPT) $(THREAD) $(SIMD) $(MOVIE) $(DBUG) $(INC) $(GSLC) $(LIBGAC) -c
+LFLAGS      = $(OPT) $(THREAD) $(GSLL) $(LIBGAL)
 
 # Distribution Directories
 DIST_BIN		= /home/wmbrown/distbin/
@@ -6,21 +6,129 @@
 #include <iostream>
 #include <math.h>
 #include <cstdlib>
+#include <algorithm>
+
+#if defined(__SSE__)
+  #include <immintrin.h>
+#endif
 
 using namespace std;
 
 #include <Node.h>
 #include <DensityGrid.h>
+#include <Checkpoint.h>
+
+// Row kernels used to stamp the fall_off matrix into the density
+// grid.  Every Add/Subtract runs one of these 2*RADIUS+1 times, so they
+// use AVX/SSE when the compiler targets it (see SIMD in Configuration.mk)
+// and finish the row with scalar code.  Each cell gets exactly the same
+// single float add or subtract as the original pointer walk.
+
+static inline void add_row ( float *den, const float *fall, int n )
+{
+  int j = 0;
+  #if defined(__AVX__)
+    for ( ; j+8 <= n; j += 8 )
+      _mm256_storeu_ps ( den+j, _mm256_add_ps ( _mm256_loadu_ps ( den+j ),
+                                                _mm256_loadu_ps ( fall+j ) ) );
+  #endif
+  #if defined(__SSE__)
+    for ( ; j+4 <= n; j += 4 )
+      _mm_storeu_ps ( den+j, _mm_add_ps ( _mm_loadu_ps ( den+j ),
+                                          _mm_loadu_ps ( fall+j ) ) );
+  #endif
+  for ( ; j < n; j++ )
+    den[j] += fall[j];
+}
+
+static inline void sub_row ( float *den, const float *fall, int n )
+{
+  int j = 0;
+  #if defined(__AVX__)
+    for ( ; j+8 <= n; j += 8 )
+      _mm256_storeu_ps ( den+j, _mm256_sub_ps ( _mm256_loadu_ps ( den+j ),
+                                                _mm256_loadu_ps ( fall+j ) ) );
+  #endif
+  #if defined(__SSE__)
+    for ( ; j+4 <= n; j += 4 )
+      _mm_storeu_ps ( den+j, _mm_sub_ps ( _mm_loadu_ps ( den+j ),
+                                          _mm_loadu_ps ( fall+j ) ) );
+  #endif
+  for ( ; j < n; j++ )
+    den[j] -= fall[j];
+}
+
+// fine_repulsion sums 1e-4/(d^2+1e-50) over n points of a fine bin.
+// The squared distance is formed in float and the quotient in double,
+// as in the original loop; the SSE2 path just keeps four partial sums.
+
+static inline double fine_repulsion ( const float *bx, const float *by, int n,
+                                      float Nx, float Ny )
+{
+  double density = 0;
+  int j = 0;
+  #if defined(__SSE2__)
+    __m128 nx = _mm_set1_ps ( Nx ), ny = _mm_set1_ps ( Ny );
+    __m128d num = _mm_set1_pd ( 1e-4 ), eps = _mm_set1_pd ( 1e-50 );
+    __m128d acc_lo = _mm_setzero_pd (), acc_hi = _mm_setzero_pd ();
+    for ( ; j+4 <= n; j += 4 ) {
+      __m128 dx = _mm_sub_ps ( nx, _mm_loadu_ps ( bx+j ) );
+      __m128 dy = _mm_sub_ps ( ny, _mm_loadu_ps ( by+j ) );
+      __m128 d = _mm_add_ps ( _mm_mul_ps ( dx, dx ), _mm_mul_ps ( dy, dy ) );
+      acc_lo = _mm_add_pd ( acc_lo, _mm_div_pd ( num, _mm_add_pd ( _mm_cvtps_pd ( d ), eps ) ) );
+      acc_hi = _mm_add_pd ( acc_hi, _mm_div_pd ( num,
+                            _mm_add_pd ( _mm_cvtps_pd ( _mm_movehl_ps ( d, d ) ), eps ) ) );
+    }
+    double lanes[2];
+    _mm_storeu_pd ( lanes, _mm_add_pd ( acc_lo, acc_hi ) );
+    density = lanes[0] + lanes[1];
+  #endif
+  for ( ; j < n; j++ ) {
+    float x_dist = Nx - bx[j];
+    float y_dist = Ny - by[j];
+    float distance = x_dist*x_dist + y_dist*y_dist;
+    density += 1e-4/(distance + 1e-50);
+  }
+  return density;
+}
 
 //*******************************************************
 // Density Grid Destructor -- deallocates memory used
-// for Density matrix, fall_off matrix, and node deque.
+// for Density matrix, fall_off matrix, and fine bins.
 
 DensityGrid::~DensityGrid ()
 {
 	delete[] Density;
 	delete[] fall_off;
-	delete[] Bins;
+	delete[] Bin_Index;
+	delete[] Row_Bins;
+}
+
+/*********************************************
+* Function: DensityServer::Init_Plane        *
+* Description: Choose the layout plane       *
+*********************************************/
+// The plane is size x size cells of 1/VIEW_TO_GRID layout units,
+// centered on the origin.  If size is 0 it is chosen from num_nodes:
+// GRID_PER_NODE*sqrt(num_nodes) cells, between MIN_GRID_SIZE and
+// max_size, rounded up to an even number so the cell boundaries
+// fall in the same place whatever the size.
+
+void DensityServer::Init_Plane ( int num_nodes, int size, int max_size )
+{
+
+  if ( size <= 0 )
+    {
+      size = (int)ceil ( GRID_PER_NODE*sqrt((double)num_nodes) );
+      if ( size < MIN_GRID_SIZE ) size = MIN_GRID_SIZE;
+      if ( size > max_size ) size = max_size;
+      size += size % 2;
+    }
+  grid_size = size;
+  view_to_grid = VIEW_TO_GRID;
+  view_size = grid_size / view_to_grid;
+  half_view = view_size / 2;
+
 }
 
 /*********************************************
@@ -30,14 +138,17 @@ DensityGrid::~DensityGrid ()
 // changed from reset to init since we will only
 // call this once in the parallel version of layout
 
-void DensityGrid::Init() 
+void DensityGrid::Init ( int num_nodes, int size )
 {
+
+  Init_Plane ( num_nodes, size, MAX_GRID_SIZE );
   
   try
     {
-      Density = new float[GRID_SIZE][GRID_SIZE];
+      Density = new float[(long)grid_size*grid_size];
       fall_off = new float[RADIUS*2+1][RADIUS*2+1];
-      Bins = new deque<Node>[GRID_SIZE][GRID_SIZE];
+      Bin_Index = new int[(long)grid_size*grid_size];
+      Row_Bins = new vector<FineBin>[grid_size];
     }
   catch (bad_alloc errora)
     {
@@ -50,11 +161,10 @@ void DensityGrid::Init()
     }
 	
   // Clear Grid
-  int i;
-  for (i=0; i< GRID_SIZE; i++) 
-    for (int j=0; j< GRID_SIZE; j++) {
-      Density[i][j] = 0;
-      Bins[i][j].erase(Bins[i][j].begin(),Bins[i][j].end());
+  long i;
+  for (i=0; i< (long)grid_size*grid_size; i++) {
+      Density[i] = 0;
+      Bin_Index[i] = -1;
     }
   
   // Compute fall off
@@ -70,44 +180,67 @@ void DensityGrid::Init()
 /***************************************************
  * Function: DensityGrid::GetDensity               *
  * Description: Get_Density from density grid      *
+ * If self is given, its own contribution (stamped *
+ * at self->sub_x, self->sub_y) is left out, as if *
+ * it had been subtracted first.                   *
  **************************************************/
-float DensityGrid::GetDensity(float Nx, float Ny, bool fineDensity) 
+float DensityGrid::GetDensity(float Nx, float Ny, bool fineDensity, Node *self,
+							   long *scanned)
 {
-	deque<Node>::iterator BI;
-	int x_grid, y_grid;
-	float x_dist, y_dist, distance, density=0;
+	FineBin *bin;
+	int x_grid, y_grid, x_self = -1, y_self = -1;
+	float density=0;
 	int boundary=10;	// boundary around plane
 
 
 	/* Where to look */
-	x_grid = (int)((Nx+HALF_VIEW+.5)*VIEW_TO_GRID);
-	y_grid = (int)((Ny+HALF_VIEW+.5)*VIEW_TO_GRID);
+	x_grid = (int)((Nx+half_view+.5)*view_to_grid);
+	y_grid = (int)((Ny+half_view+.5)*view_to_grid);
 
 	// Check for edges of density grid (10000 is arbitrary high density)
-	if (x_grid > GRID_SIZE-boundary || x_grid < boundary) return 10000;
-	if (y_grid > GRID_SIZE-boundary || y_grid < boundary) return 10000;
+	if (x_grid > grid_size-boundary || x_grid < boundary) return 10000;
+	if (y_grid > grid_size-boundary || y_grid < boundary) return 10000;
+
+	/* Where self was added */
+	if (self) {
+		x_self = (int)((self->sub_x+half_view+.5)*view_to_grid);
+		y_self = (int)((self->sub_y+half_view+.5)*view_to_grid);
+	}
 
 	// Fine density?
 	if (fineDensity) {
 
+		double fine = 0;
+
 		// Go through nearest bins
 		for(int i=y_grid-1; i<=y_grid+1; i++)
 			for(int j=x_grid-1; j<=x_grid+1; j++) {
 
 			// Look through bin and add fine repulsions
-			for(BI = Bins[i][j].begin(); BI < Bins[i][j].end(); ++BI) {
-				x_dist =  Nx-(BI->x);
-				y_dist =  Ny-(BI->y);
-				distance = x_dist*x_dist+y_dist*y_dist;
-				density += 1e-4/(distance + 1e-50);
-		 }
+			if (scanned) (*scanned)++;
+			if ((bin = GetBin(i, j)) == NULL) continue;
+			int n = (int)bin->x.size(), k = n;
+
+			// skip self's own entry (fineSubtract would have removed it)
+			if (i == y_self && j == x_self)
+				for (k = 0; k < n && bin->id[k] != self->id; k++);
+
+			if (k == n)
+				fine += fine_repulsion(&bin->x[0], &bin->y[0], n, Nx, Ny);
+			else
+				fine += fine_repulsion(&bin->x[0], &bin->y[0], k, Nx, Ny) +
+						fine_repulsion(&bin->x[k+1], &bin->y[k+1], n-k-1, Nx, Ny);
 		}
+		density = (float)fine;
 
 	// Course density
 	} else {
 
 		// Add rough estimate
-		density = Density[y_grid][x_grid];
+		if (scanned) (*scanned)++;
+		density = Density[y_grid*grid_size+x_grid];
+		if (self && abs(y_grid-y_self) <= RADIUS && abs(x_grid-x_self) <= RADIUS)
+			density -= fall_off[y_grid-y_self+RADIUS][x_grid-x_self+RADIUS];
 		density *= density;
 	}
 
@@ -132,6 +265,21 @@ void DensityGrid::Subtract( Node &n, bool first_add,
   else if ( !first_add ) Subtract(n);
 }
 
+// Move is Subtract (at n.sub_x, n.sub_y) followed by Add (at n.x, n.y),
+// which can skip the grid entirely for coarse stamps that do not move
+
+void DensityGrid::Move( Node &n, bool first_add,
+						bool fine_first_add, bool fineDensity)
+{
+  if ( fineDensity || first_add )
+  {
+    Subtract ( n, first_add, fine_first_add, fineDensity );
+    Add ( n, fineDensity );
+  }
+  else
+    Move ( n );
+}
+
 			
 /***************************************************
  * Function: DensityGrid::Subtract                *
@@ -143,19 +291,19 @@ void DensityGrid::Subtract(Node &N)
   float *den_ptr, *fall_ptr;
 	
   /* Where to subtract */
-  x_grid = (int)((N.sub_x+HALF_VIEW+.5)*VIEW_TO_GRID);
-  y_grid = (int)((N.sub_y+HALF_VIEW+.5)*VIEW_TO_GRID);
+  x_grid = (int)((N.sub_x+half_view+.5)*view_to_grid);
+  y_grid = (int)((N.sub_y+half_view+.5)*view_to_grid);
   x_grid -= RADIUS;
   y_grid -= RADIUS;
   diam = 2*RADIUS;
 
   /* Subtract density values */
-  den_ptr = &Density[y_grid][x_grid];
+  den_ptr = &Density[y_grid*grid_size+x_grid];
   fall_ptr = &fall_off[0][0];
   for(int i = 0; i <= diam; i++) {
-    for(int j = 0; j <= diam; j++)
-	 *den_ptr++ -= *fall_ptr++;
-    den_ptr += GRID_SIZE - (diam+1);
+    sub_row ( den_ptr, fall_ptr, diam+1 );
+    den_ptr += grid_size;
+    fall_ptr += diam+1;
   }
 }
 
@@ -171,8 +319,8 @@ void DensityGrid::Add(Node &N)
 
 
   /* Where to add */
-  x_grid = (int)((N.x+HALF_VIEW+.5)*VIEW_TO_GRID);
-  y_grid = (int)((N.y+HALF_VIEW+.5)*VIEW_TO_GRID);
+  x_grid = (int)((N.x+half_view+.5)*view_to_grid);
+  y_grid = (int)((N.y+half_view+.5)*view_to_grid);
  
   N.sub_x = N.x;
   N.sub_y = N.y;
@@ -182,8 +330,8 @@ void DensityGrid::Add(Node &N)
   diam = 2*RADIUS;
 
   // check to see that we are inside grid
-  if ( (x_grid >= GRID_SIZE) || (x_grid < 0) ||
-       (y_grid >= GRID_SIZE) || (y_grid < 0) )
+  if ( (x_grid >= grid_size) || (x_grid < 0) ||
+       (y_grid >= grid_size) || (y_grid < 0) )
     {
       cout << endl << "Error: Exceeded density grid with x_grid = " << x_grid 
 	       << " and y_grid = " << y_grid << ".  Program stopped." << endl;
@@ -195,28 +343,115 @@ void DensityGrid::Add(Node &N)
     }    
 
   /* Add density values */
-  den_ptr = &Density[y_grid][x_grid];
+  den_ptr = &Density[y_grid*grid_size+x_grid];
   fall_ptr = &fall_off[0][0];
   for(int i = 0; i <= diam; i++) {
-    for(int j = 0; j <= diam; j++)
-	 *den_ptr++ += *fall_ptr++;
-    den_ptr += GRID_SIZE - (diam+1);
+    add_row ( den_ptr, fall_ptr, diam+1 );
+    den_ptr += grid_size;
+    fall_ptr += diam+1;
   }
   
 }
 
+/***************************************************
+ * Function: DensityGrid::Move                     *
+ * Description: Move a node in the density grid    *
+ * from (sub_x, sub_y) to (x, y).  Late in the     *
+ * layout most nodes stay in the same grid cell,   *
+ * where the two stamps cancel and the grid is not *
+ * touched at all.  (Interleaving the subtract and *
+ * add rows of overlapping stamps was measured to  *
+ * be slower than two sweeps -- see stamp_bench.)  *
+ **************************************************/
+void DensityGrid::Move(Node &N)
+{
+
+  int old_x, old_y, new_x, new_y, diam;
+
+  old_x = (int)((N.sub_x+half_view+.5)*view_to_grid) - RADIUS;
+  old_y = (int)((N.sub_y+half_view+.5)*view_to_grid) - RADIUS;
+  new_x = (int)((N.x+half_view+.5)*view_to_grid) - RADIUS;
+  new_y = (int)((N.y+half_view+.5)*view_to_grid) - RADIUS;
+  diam = 2*RADIUS;
+
+  // check to see that we are inside grid
+  if ( (new_x >= grid_size) || (new_x < 0) ||
+       (new_y >= grid_size) || (new_y < 0) )
+    {
+      cout << endl << "Error: Exceeded density grid with x_grid = " << new_x
+	       << " and y_grid = " << new_y << ".  Program stopped." << endl;
+      #ifdef MUSE_MPI
+ 	    MPI_Abort ( MPI_COMM_WORLD, 1 );
+	  #else
+	    exit (1);
+	  #endif
+    }
+
+  N.sub_x = N.x;
+  N.sub_y = N.y;
+
+  // both stamps on the same cell cancel
+  if ( old_x == new_x && old_y == new_y )
+    return;
+
+  // otherwise subtract then add, each as one sweep of rows
+  for ( int i = 0; i <= diam; i++ )
+    sub_row ( &Density[(old_y+i)*grid_size+old_x], fall_off[i], diam+1 );
+  for ( int i = 0; i <= diam; i++ )
+    add_row ( &Density[(new_y+i)*grid_size+new_x], fall_off[i], diam+1 );
+
+}
+
+/***************************************************
+ * Function: DensityGrid::GetBin / NewBin          *
+ * Description: Only cells holding nodes have a    *
+ * fine bin.  Bins live in a list per grid row, so *
+ * threads owning different rows never share one.  *
+ * Emptied bins stay put and are reused.           *
+ **************************************************/
+FineBin *DensityGrid::GetBin(int y_grid, int x_grid)
+{
+  int index = Bin_Index[y_grid*grid_size+x_grid];
+  return index < 0 ? NULL : &Row_Bins[y_grid][index];
+}
+
+FineBin &DensityGrid::NewBin(int y_grid, int x_grid)
+{
+  int &index = Bin_Index[y_grid*grid_size+x_grid];
+  if ( index < 0 ) {
+    index = (int)Row_Bins[y_grid].size();
+    Row_Bins[y_grid].push_back ( FineBin() );
+  }
+  return Row_Bins[y_grid][index];
+}
+
 /***************************************************
  * Function: DensityGrid::fineSubtract             *
  * Description: Subtract a node from bins		   *
+ * The node is found by id and the last entry of   *
+ * the bin is moved into its place.                *
  **************************************************/
 void DensityGrid::fineSubtract(Node &N) 
 {
   int x_grid, y_grid;
+  FineBin *bin;
 
   /* Where to subtract */
-  x_grid = (int)((N.sub_x+HALF_VIEW+.5)*VIEW_TO_GRID);
-  y_grid = (int)((N.sub_y+HALF_VIEW+.5)*VIEW_TO_GRID);
-  Bins[y_grid][x_grid].pop_front();
+  x_grid = (int)((N.sub_x+half_view+.5)*view_to_grid);
+  y_grid = (int)((N.sub_y+half_view+.5)*view_to_grid);
+  if ( (bin = GetBin(y_grid, x_grid)) == NULL ) return;
+
+  int last = (int)bin->id.size() - 1;
+  for ( int k = last; k >= 0; k-- )
+    if ( bin->id[k] == N.id ) {
+      bin->x[k] = bin->x[last];
+      bin->y[k] = bin->y[last];
+      bin->id[k] = bin->id[last];
+      bin->x.pop_back();
+      bin->y.pop_back();
+      bin->id.pop_back();
+      return;
+    }
 }
 
 /***************************************************
@@ -228,9 +463,170 @@ void DensityGrid::fineAdd(Node &N)
   int x_grid, y_grid;
 
   /* Where to add */
-  x_grid = (int)((N.x+HALF_VIEW+.5)*VIEW_TO_GRID);
-  y_grid = (int)((N.y+HALF_VIEW+.5)*VIEW_TO_GRID);
+  x_grid = (int)((N.x+half_view+.5)*view_to_grid);
+  y_grid = (int)((N.y+half_view+.5)*view_to_grid);
   N.sub_x = N.x;
   N.sub_y = N.y;
-  Bins[y_grid][x_grid].push_back(N);
+
+  FineBin &bin = NewBin(y_grid, x_grid);
+  bin.x.push_back(N.x);
+  bin.y.push_back(N.y);
+  bin.id.push_back(N.id);
+}
+
+/***************************************************
+ * Function: DensityGrid::Add / Subtract (batched) *
+ * Description: Row-restricted versions of Add and *
+ * Subtract for the threaded engine.  Each thread  *
+ * owns a band of grid rows and applies every move *
+ * in the batch to its own band only.  The node's  *
+ * sub_x, sub_y are left for the caller to update. *
+ **************************************************/
+
+void DensityGrid::Add(Node &n, bool fineDensity, int row_lo, int row_hi)
+{
+  if(fineDensity)
+    fineAdd(n, row_lo, row_hi);
+  else
+    Add(n.x, n.y, row_lo, row_hi);
+}
+
+void DensityGrid::Subtract( Node &n, bool first_add,
+							bool fine_first_add, bool fineDensity,
+							int row_lo, int row_hi )
+{
+  if ( fineDensity && !fine_first_add ) fineSubtract (n, row_lo, row_hi);
+  else if ( !first_add ) Subtract(n.sub_x, n.sub_y, row_lo, row_hi);
+}
+
+void DensityGrid::Subtract( float sub_x, float sub_y, int row_lo, int row_hi )
+{
+  int x_grid, y_grid, i_lo, i_hi;
+
+  x_grid = (int)((sub_x+half_view+.5)*view_to_grid) - RADIUS;
+  y_grid = (int)((sub_y+half_view+.5)*view_to_grid) - RADIUS;
+
+  // rows of the fall off stamp inside this band
+  i_lo = row_lo - y_grid;
+  if ( i_lo < 0 ) i_lo = 0;
+  i_hi = row_hi - y_grid;
+  if ( i_hi > 2*RADIUS+1 ) i_hi = 2*RADIUS+1;
+
+  for(int i = i_lo; i < i_hi; i++)
+    sub_row ( &Density[(y_grid+i)*grid_size+x_grid], fall_off[i], 2*RADIUS+1 );
+}
+
+void DensityGrid::Add( float x, float y, int row_lo, int row_hi )
+{
+  int x_grid, y_grid, i_lo, i_hi;
+
+  x_grid = (int)((x+half_view+.5)*view_to_grid) - RADIUS;
+  y_grid = (int)((y+half_view+.5)*view_to_grid) - RADIUS;
+
+  // check to see that we are inside grid (first band reports)
+  if ( (x_grid >= grid_size) || (x_grid < 0) ||
+       (y_grid >= grid_size) || (y_grid < 0) )
+    {
+      if ( row_lo > 0 ) return;
+      cout << endl << "Error: Exceeded density grid with x_grid = " << x_grid 
+	       << " and y_grid = " << y_grid << ".  Program stopped." << endl;
+      #ifdef MUSE_MPI
+ 	    MPI_Abort ( MPI_COMM_WORLD, 1 );
+	  #else
+	    exit (1);
+	  #endif
+    }
+
+  i_lo = row_lo - y_grid;
+  if ( i_lo < 0 ) i_lo = 0;
+  i_hi = row_hi - y_grid;
+  if ( i_hi > 2*RADIUS+1 ) i_hi = 2*RADIUS+1;
+
+  for(int i = i_lo; i < i_hi; i++)
+    add_row ( &Density[(y_grid+i)*grid_size+x_grid], fall_off[i], 2*RADIUS+1 );
+}
+
+void DensityGrid::fineSubtract( Node &N, int row_lo, int row_hi )
+{
+  int y_grid;
+
+  y_grid = (int)((N.sub_y+half_view+.5)*view_to_grid);
+  if ( y_grid >= row_lo && y_grid < row_hi )
+    fineSubtract(N);
+}
+
+void DensityGrid::fineAdd( Node &N, int row_lo, int row_hi )
+{
+  int x_grid, y_grid;
+
+  x_grid = (int)((N.x+half_view+.5)*view_to_grid);
+  y_grid = (int)((N.y+half_view+.5)*view_to_grid);
+  if ( y_grid >= row_lo && y_grid < row_hi ) {
+    FineBin &bin = NewBin(y_grid, x_grid);
+    bin.x.push_back(N.x);
+    bin.y.push_back(N.y);
+    bin.id.push_back(N.id);
+  }
+}
+
+/***************************************************
+ * Function: DensityGrid::Write / Read             *
+ * Description: Save and restore the density grid  *
+ * and fine bins (checkpoints).  Bins are saved in *
+ * the order of each row's list, nodes in the      *
+ * order of each bin, as the density sums depend   *
+ * on that order.                                  *
+ **************************************************/
+void DensityGrid::Write ( ostream &out )
+{
+  write_value ( out, grid_size );
+  out.write ( (const char *)Density, (long)grid_size*grid_size*sizeof(float) );
+
+  vector<int> bin_x;
+  for ( int y_grid = 0; y_grid < grid_size; y_grid++ )
+    {
+      // x of each bin in the row list
+      bin_x.assign ( Row_Bins[y_grid].size(), -1 );
+      for ( int x_grid = 0; x_grid < grid_size; x_grid++ )
+        if ( Bin_Index[y_grid*grid_size+x_grid] >= 0 )
+          bin_x[Bin_Index[y_grid*grid_size+x_grid]] = x_grid;
+
+      write_vector ( out, bin_x );
+      for ( unsigned int k = 0; k < bin_x.size(); k++ )
+        {
+          write_vector ( out, Row_Bins[y_grid][k].x );
+          write_vector ( out, Row_Bins[y_grid][k].y );
+          write_vector ( out, Row_Bins[y_grid][k].id );
+        }
+    }
+}
+
+bool DensityGrid::Read ( istream &in )
+{
+  int saved_size;
+  if ( !read_value ( in, saved_size ) || saved_size != grid_size )
+    return false;
+  in.read ( (char *)Density, (long)grid_size*grid_size*sizeof(float) );
+
+  vector<int> bin_x;
+  for ( int y_grid = 0; y_grid < grid_size && in; y_grid++ )
+    {
+      if ( !read_vector ( in, bin_x ) )
+        return false;
+      for ( int x_grid = 0; x_grid < grid_size; x_grid++ )
+        Bin_Index[y_grid*grid_size+x_grid] = -1;
+      Row_Bins[y_grid].assign ( bin_x.size(), FineBin() );
+      for ( unsigned int k = 0; k < bin_x.size(); k++ )
+        {
+          if ( bin_x[k] < 0 || bin_x[k] >= grid_size )
+            return false;
+          Bin_Index[y_grid*grid_size+bin_x[k]] = k;
+          if ( !read_vector ( in, Row_Bins[y_grid][k].x ) ||
+               !read_vector ( in, Row_Bins[y_grid][k].y ) ||
+               !read_vector ( in, Row_Bins[y_grid][k].id ) )
+            return false;
+        }
+    }
+
+  return (bool)in;
 }
@@ -5,28 +5,49 @@
 // Compile time adjustable parameters
 
 
-#include <deque>
+#include <vector>
 
 using namespace std;
 
 #include "layout.h"
 #include "Node.h"
+#include "DensityServer.h"
 #ifdef MUSE_MPI
   #include <mpi.h>
 #endif
 
-class DensityGrid {
+// A fine density bin holds the nodes stamped into one grid cell.
+// Coordinates are kept in separate arrays so the repulsion loop in
+// GetDensity streams through just the x and y values it needs.
+
+struct FineBin {
+  vector<float> x, y;
+  vector<int> id;
+};
+
+class DensityGrid : public DensityServer {
 
 public:
   
 	  // Methods
-	  void Init();
+	  void Init ( int num_nodes, int size = 0 );
 	  void Subtract(Node &n, bool first_add, bool fine_first_add, bool fineDensity);
 	  void Add(Node &n, bool fineDensity );
-	  float GetDensity(float Nx, float Ny, bool fineDensity);
+	  void Move(Node &n, bool first_add, bool fine_first_add, bool fineDensity);
+	  float GetDensity(float Nx, float Ny, bool fineDensity, Node *self = NULL,
+					   long *scanned = NULL);
+
+	  // Batched updates used by the threaded engine
+	  void Subtract(Node &n, bool first_add, bool fine_first_add,
+					bool fineDensity, int row_lo, int row_hi);
+	  void Add(Node &n, bool fineDensity, int row_lo, int row_hi);
+
+	  // checkpoints
+	  void Write ( ostream &out );
+	  bool Read ( istream &in );
 
 	  // Contructor/Destructor
-	  DensityGrid() {};
+	  DensityGrid() : fall_off ( NULL ), Density ( NULL ), Bin_Index ( NULL ), Row_Bins ( NULL ) {};
 	  ~DensityGrid();
 
 private:
@@ -36,11 +57,19 @@ private:
 	  void Add( Node &N );
 	  void fineSubtract( Node &N );
 	  void fineAdd( Node &N );
+	  void Move( Node &N );
+	  void Subtract( float sub_x, float sub_y, int row_lo, int row_hi );
+	  void Add( float x, float y, int row_lo, int row_hi );
+	  void fineSubtract( Node &N, int row_lo, int row_hi );
+	  FineBin *GetBin( int y_grid, int x_grid );
+	  FineBin &NewBin( int y_grid, int x_grid );
+	  void fineAdd( Node &N, int row_lo, int row_hi );
 
 	  // new dynamic variables -- SBM
 	  float (*fall_off)[RADIUS*2+1];
-	  float (*Density)[GRID_SIZE];
-	  deque<Node> (*Bins)[GRID_SIZE];
+	  float *Density;			// grid_size x grid_size, row major
+	  int *Bin_Index;			// index into Row_Bins[row], -1 if unused
+	  vector<FineBin> *Row_Bins;	// bins in use, one list per grid row
 
 	  // old static variables
 	  //float fall_off[RADIUS*2+1][RADIUS*2+1];
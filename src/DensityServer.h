@@ -0,0 +1,66 @@
+#ifndef __DENSITY_SERVER_H__
+#define __DENSITY_SERVER_H__
+
+// The DensityServer class is the interface graph uses for repulsion.
+// Nodes are added to, moved in and subtracted from the server, which
+// gives the density (repulsion energy) at any point of the layout
+// plane.  DensityGrid stamps nodes into a density grid; DensityTree
+// keeps them in a Barnes-Hut quadtree.
+//
+// Both use the same layout plane: grid_size x grid_size cells of
+// 1/VIEW_TO_GRID layout units, centered on the origin.
+
+#include <iostream>
+
+using namespace std;
+
+#include "layout.h"
+#include "Node.h"
+
+class DensityServer {
+
+public:
+
+	  // Methods
+	  virtual void Init ( int num_nodes, int size = 0 ) = 0;
+	  int Grid_Size () { return grid_size; }
+	  float View_Size () { return view_size; }
+	  virtual void Subtract(Node &n, bool first_add, bool fine_first_add, bool fineDensity) = 0;
+	  virtual void Add(Node &n, bool fineDensity ) = 0;
+	  virtual void Move(Node &n, bool first_add, bool fine_first_add, bool fineDensity) = 0;
+	  // (scanned, if given, is increased by the bins or cells read)
+	  virtual float GetDensity(float Nx, float Ny, bool fineDensity, Node *self = NULL,
+							   long *scanned = NULL) = 0;
+
+	  // Batched updates used by the threaded engine: only grid
+	  // rows [row_lo,row_hi) are touched so several threads can
+	  // apply the same batch of moves at once
+	  virtual void Subtract(Node &n, bool first_add, bool fine_first_add,
+							bool fineDensity, int row_lo, int row_hi) = 0;
+	  virtual void Add(Node &n, bool fineDensity, int row_lo, int row_hi) = 0;
+
+	  // called by graph at the start of each iteration
+	  virtual void Rebuild () { }
+
+	  // checkpoint (layout -k): the density state is saved exactly,
+	  // so a resumed layout gets the same densities.  Read returns
+	  // false if the saved state does not fit this server.
+	  virtual void Write ( ostream &out ) = 0;
+	  virtual bool Read ( istream &in ) = 0;
+
+	  // Contructor/Destructor
+	  DensityServer() : grid_size ( 0 ) {};
+	  virtual ~DensityServer() {};
+
+protected:
+
+	  void Init_Plane ( int num_nodes, int size, int max_size );
+
+	  // grid geometry, set by Init
+	  int grid_size;			// size of Density grid
+	  float view_size;			// actual physical size of layout plane
+	  float half_view;			// 1/2 of view_size
+	  float view_to_grid;		// ratio of grid_size to view_size
+};
+
+#endif // __DENSITY_SERVER_H__
@@ -0,0 +1,431 @@
+// This file contains the member definitions of the DensityTree.h class
+
+#include <iostream>
+#include <math.h>
+#include <cstdlib>
+
+using namespace std;
+
+#include <Node.h>
+#include <DensityTree.h>
+#include <Checkpoint.h>
+#ifdef MUSE_MPI
+  #include <mpi.h>
+#endif
+
+/*********************************************
+* Function: DensityTree::Init                *
+* Description: Set up an empty tree          *
+*********************************************/
+// The plane is chosen as for DensityGrid.  The root covers twice the
+// plane in each direction, so it holds every position Add accepts.
+
+void DensityTree::Init ( int num_nodes, int size )
+{
+
+  Init_Plane ( num_nodes, size, MAX_TREE_GRID_SIZE );
+
+  float radius = RADIUS / view_to_grid;
+  kernel_scale = 4.0 / (radius*radius);
+  min_size = ldexp ( 2*view_size, -TREE_MAX_DEPTH );
+
+  Rebuild ();
+
+}
+
+/*********************************************
+* Function: DensityTree::Rebuild             *
+* Description: Rebuild the tree from scratch *
+*********************************************/
+// Cells are never merged as nodes move, so once an iteration the
+// nodes in the tree are inserted again into a new tree.  This also
+// clears the rounding left in the cell sums by the moves.
+
+void DensityTree::Rebuild ()
+{
+
+  TreeCell root;
+  root.x0 = root.y0 = -view_size;
+  root.size = 2*view_size;
+  root.cx = root.cy = 0;
+  root.mass = 0;
+  root.mx = root.my = 0;
+  root.parent = root.child = -1;
+  root.head = -1;
+  root.count = 0;
+
+  cells.clear ();
+  cells.push_back ( root );
+
+  for ( int id = 0; id < (int)node_leaf.size(); id++ )
+    if ( node_leaf[id] >= 0 )
+      {
+        node_leaf[id] = -1;
+        Insert ( id, node_x[id], node_y[id] );
+      }
+
+}
+
+/***************************************************
+ * Function: DensityTree::GetDensity               *
+ * Description: Get_Density from the tree          *
+ * If self is given, its own contribution is left  *
+ * out, as if it had been subtracted first.        *
+ **************************************************/
+float DensityTree::GetDensity(float Nx, float Ny, bool fineDensity, Node *self,
+							   long *scanned)
+{
+	int x_grid, y_grid;
+	float density;
+	int boundary=10;	// boundary around plane
+
+	/* Where to look */
+	x_grid = (int)((Nx+half_view+.5)*view_to_grid);
+	y_grid = (int)((Ny+half_view+.5)*view_to_grid);
+
+	// Check for edges of layout plane (10000 is arbitrary high density)
+	if (x_grid > grid_size-boundary || x_grid < boundary) return 10000;
+	if (y_grid > grid_size-boundary || y_grid < boundary) return 10000;
+
+	// Fine density?
+	if (fineDensity)
+		return (float)Fine(Nx, Ny, self ? self->id : -1, scanned);
+
+	// Course density
+	density = Coarse(Nx, Ny, scanned);
+	if (self && self->id < (int)node_leaf.size() && node_leaf[self->id] >= 0) {
+		float x_dist = Nx - node_x[self->id];
+		float y_dist = Ny - node_y[self->id];
+		density -= 1 / (1 + (x_dist*x_dist + y_dist*y_dist)*kernel_scale);
+		if (density < 0) density = 0;
+	}
+	density *= density;
+
+	return density;
+}
+
+// Coarse sums K over the nodes in the tree, opening cells which are
+// too close for the opening angle
+
+float DensityTree::Coarse ( float Nx, float Ny, long *scanned )
+{
+  int stack[4*TREE_MAX_DEPTH+4], top = 0, visited = 0;
+  float theta2 = theta*theta;
+  double density = 0;
+
+  stack[top++] = 0;
+  while ( top > 0 )
+    {
+      const TreeCell &cell = cells[stack[--top]];
+      visited++;
+      if ( cell.mass <= 0 )
+        continue;
+
+      // far enough to use the center of mass?  (a leaf which could
+      // not be split holds nodes at almost the same position)
+      float x_dist = Nx - cell.cx;
+      float y_dist = Ny - cell.cy;
+      float distance = x_dist*x_dist + y_dist*y_dist;
+      if ( cell.size*cell.size < theta2*distance || cell.size <= min_size )
+        density += cell.mass / (1 + distance*kernel_scale);
+
+      // leaf: add up its nodes
+      else if ( cell.child < 0 )
+        for ( int id = cell.head; id >= 0; id = node_next[id] )
+          {
+            x_dist = Nx - node_x[id];
+            y_dist = Ny - node_y[id];
+            density += 1 / (1 + (x_dist*x_dist + y_dist*y_dist)*kernel_scale);
+          }
+
+      else
+        for ( int q = 0; q < 4; q++ )
+          stack[top++] = cell.child + q;
+    }
+
+  if ( scanned )
+    *scanned += visited;
+  return (float)density;
+}
+
+// Fine sums the fine repulsion of DensityGrid over the nodes in the
+// 3 x 3 grid cells around (Nx, Ny), leaving out self_id
+
+double DensityTree::Fine ( float Nx, float Ny, int self_id, long *scanned )
+{
+  int stack[4*TREE_MAX_DEPTH+4], top = 0, visited = 0;
+  double density = 0;
+
+  // the grid cells searched, and the part of the plane they cover
+  // (with a margin, since nodes are checked by grid cell below)
+  int x_grid = (int)((Nx+half_view+.5)*view_to_grid);
+  int y_grid = (int)((Ny+half_view+.5)*view_to_grid);
+  float x_lo = (x_grid-1) / view_to_grid - half_view - 1.5;
+  float x_hi = (x_grid+2) / view_to_grid - half_view + .5;
+  float y_lo = (y_grid-1) / view_to_grid - half_view - 1.5;
+  float y_hi = (y_grid+2) / view_to_grid - half_view + .5;
+
+  stack[top++] = 0;
+  while ( top > 0 )
+    {
+      const TreeCell &cell = cells[stack[--top]];
+      visited++;
+      if ( cell.mass <= 0 || cell.x0 > x_hi || cell.x0 + cell.size < x_lo ||
+           cell.y0 > y_hi || cell.y0 + cell.size < y_lo )
+        continue;
+
+      if ( cell.child >= 0 )
+        {
+          for ( int q = 0; q < 4; q++ )
+            stack[top++] = cell.child + q;
+          continue;
+        }
+
+      for ( int id = cell.head; id >= 0; id = node_next[id] )
+        {
+          if ( id == self_id )
+            continue;
+          int x_bin = (int)((node_x[id]+half_view+.5)*view_to_grid);
+          int y_bin = (int)((node_y[id]+half_view+.5)*view_to_grid);
+          if ( abs(x_bin-x_grid) > 1 || abs(y_bin-y_grid) > 1 )
+            continue;
+          float x_dist = Nx - node_x[id];
+          float y_dist = Ny - node_y[id];
+          float distance = x_dist*x_dist + y_dist*y_dist;
+          density += 1e-4/(distance + 1e-50);
+        }
+    }
+
+  if ( scanned )
+    *scanned += visited;
+  return density;
+}
+
+/// Wrapper functions for the Add and subtract methods.  The tree
+/// holds one entry per node for both densities, so Subtract removes
+/// it whenever DensityGrid would subtract from either, and Add (or
+/// Move) puts it at its new position.
+
+void DensityTree::Add(Node &n, bool)
+{
+  int x_grid, y_grid;
+
+  /* Where to add */
+  x_grid = (int)((n.x+half_view+.5)*view_to_grid) - RADIUS;
+  y_grid = (int)((n.y+half_view+.5)*view_to_grid) - RADIUS;
+
+  // check to see that we are inside the plane (as DensityGrid does)
+  if ( (x_grid >= grid_size) || (x_grid < 0) ||
+       (y_grid >= grid_size) || (y_grid < 0) )
+    {
+      cout << endl << "Error: Exceeded density grid with x_grid = " << x_grid
+	       << " and y_grid = " << y_grid << ".  Program stopped." << endl;
+      #ifdef MUSE_MPI
+ 	    MPI_Abort ( MPI_COMM_WORLD, 1 );
+	  #else
+	    exit (1);
+	  #endif
+    }
+
+  n.sub_x = n.x;
+  n.sub_y = n.y;
+  Insert ( n.id, n.x, n.y );
+}
+
+void DensityTree::Subtract( Node &n, bool first_add,
+							bool fine_first_add, bool fineDensity)
+{
+  if ( (fineDensity && !fine_first_add) || !first_add )
+    Remove ( n.id );
+}
+
+void DensityTree::Move( Node &n, bool first_add,
+						bool fine_first_add, bool fineDensity)
+{
+  Subtract ( n, first_add, fine_first_add, fineDensity );
+  Add ( n, fineDensity );
+}
+
+void DensityTree::Add(Node &n, bool fineDensity, int row_lo, int)
+{
+  if ( row_lo == 0 )
+    Add ( n, fineDensity );
+}
+
+void DensityTree::Subtract( Node &n, bool first_add,
+							bool fine_first_add, bool fineDensity,
+							int row_lo, int )
+{
+  if ( row_lo == 0 )
+    Subtract ( n, first_add, fine_first_add, fineDensity );
+}
+
+/***************************************************
+ * Function: DensityTree::Insert / Remove          *
+ * Description: Put a node in the tree (moving it  *
+ * if it is there already) or take it out.  The    *
+ * sums of every cell on the way are updated.      *
+ **************************************************/
+void DensityTree::Insert ( int id, float x, float y )
+{
+  if ( id >= (int)node_leaf.size() )
+    {
+      node_x.resize ( id+1 );
+      node_y.resize ( id+1 );
+      node_leaf.resize ( id+1, -1 );
+      node_next.resize ( id+1 );
+      node_prev.resize ( id+1 );
+    }
+  if ( node_leaf[id] >= 0 )
+    Remove ( id );
+
+  node_x[id] = x;
+  node_y[id] = y;
+
+  int c = 0;
+  while ( true )
+    {
+      Gain ( cells[c], x, y, 1 );
+      if ( cells[c].child < 0 )
+        break;
+      c = cells[c].child + Quadrant ( c, x, y );
+    }
+
+  Link ( c, id );
+  if ( cells[c].count > TREE_LEAF_SIZE && cells[c].size > min_size )
+    Split ( c );
+}
+
+void DensityTree::Remove ( int id )
+{
+  if ( id >= (int)node_leaf.size() || node_leaf[id] < 0 )
+    return;
+
+  int c = node_leaf[id];
+  if ( node_prev[id] >= 0 )
+    node_next[node_prev[id]] = node_next[id];
+  else
+    cells[c].head = node_next[id];
+  if ( node_next[id] >= 0 )
+    node_prev[node_next[id]] = node_prev[id];
+  cells[c].count--;
+  node_leaf[id] = -1;
+
+  for ( ; c >= 0; c = cells[c].parent )
+    Gain ( cells[c], node_x[id], node_y[id], -1 );
+}
+
+// Split turns a full leaf into four children and hands its nodes
+// down to them
+
+void DensityTree::Split ( int cell )
+{
+  int first = (int)cells.size();
+  float half = cells[cell].size / 2;
+
+  for ( int q = 0; q < 4; q++ )
+    {
+      TreeCell child;
+      child.x0 = cells[cell].x0 + (q & 1)*half;
+      child.y0 = cells[cell].y0 + (q >> 1)*half;
+      child.size = half;
+      child.cx = child.cy = 0;
+      child.mass = 0;
+      child.mx = child.my = 0;
+      child.parent = cell;
+      child.child = -1;
+      child.head = -1;
+      child.count = 0;
+      cells.push_back ( child );
+    }
+
+  int id = cells[cell].head, next;
+  cells[cell].child = first;
+  cells[cell].head = -1;
+  cells[cell].count = 0;
+  for ( ; id >= 0; id = next )
+    {
+      next = node_next[id];
+      int c = first + Quadrant ( cell, node_x[id], node_y[id] );
+      Gain ( cells[c], node_x[id], node_y[id], 1 );
+      Link ( c, id );
+    }
+
+  for ( int q = 0; q < 4; q++ )
+    if ( cells[first+q].count > TREE_LEAF_SIZE && cells[first+q].size > min_size )
+      Split ( first+q );
+}
+
+// Gain adds (sign 1) or takes away (sign -1) a node at x, y from
+// the sums of a cell
+
+void DensityTree::Gain ( TreeCell &cell, float x, float y, int sign )
+{
+  cell.mass += sign;
+  cell.mx += sign*x;
+  cell.my += sign*y;
+  if ( cell.mass > 0 )
+    {
+      cell.cx = (float)(cell.mx / cell.mass);
+      cell.cy = (float)(cell.my / cell.mass);
+    }
+}
+
+void DensityTree::Link ( int cell, int id )
+{
+  node_prev[id] = -1;
+  node_next[id] = cells[cell].head;
+  if ( cells[cell].head >= 0 )
+    node_prev[cells[cell].head] = id;
+  cells[cell].head = id;
+  cells[cell].count++;
+  node_leaf[id] = cell;
+}
+
+int DensityTree::Quadrant ( int cell, float x, float y )
+{
+  float half = cells[cell].size / 2;
+  return ( x >= cells[cell].x0 + half ) + 2*( y >= cells[cell].y0 + half );
+}
+
+/*********************************************
+* Function: DensityTree::Write / Read        *
+* Description: Save and restore the nodes    *
+*********************************************/
+// Only the nodes are saved.  graph rebuilds the tree from them at
+// the start of every iteration, so the tree Read rebuilds is the
+// one the layout would have used.
+
+void DensityTree::Write ( ostream &out )
+{
+  vector<char> present ( node_leaf.size() );
+  for ( unsigned int id = 0; id < node_leaf.size(); id++ )
+    present[id] = node_leaf[id] >= 0;
+
+  write_value ( out, grid_size );
+  write_vector ( out, node_x );
+  write_vector ( out, node_y );
+  write_vector ( out, present );
+}
+
+bool DensityTree::Read ( istream &in )
+{
+  int saved_size;
+  vector<char> present;
+  if ( !read_value ( in, saved_size ) || saved_size != grid_size ||
+       !read_vector ( in, node_x ) || !read_vector ( in, node_y ) ||
+       !read_vector ( in, present ) )
+    return false;
+  if ( node_x.size() != present.size() || node_y.size() != present.size() )
+    return false;
+
+  node_leaf.assign ( present.size(), -1 );
+  node_next.assign ( present.size(), -1 );
+  node_prev.assign ( present.size(), -1 );
+  for ( unsigned int id = 0; id < present.size(); id++ )
+    if ( present[id] )
+      node_leaf[id] = 0;
+  Rebuild ();
+
+  return true;
+}
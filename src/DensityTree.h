@@ -0,0 +1,90 @@
+#ifndef __DENSITY_TREE_H__
+#define __DENSITY_TREE_H__
+
+// The DensityTree class is a Barnes-Hut version of DensityGrid.
+// Nodes are kept in a quadtree over the layout plane, so memory grows
+// with the number of nodes rather than with the size of the plane.
+//
+// The coarse density at a point is (sum of K over all nodes)^2, where
+// K(d) = 1/(1 + (2d/R)^2) and R is the RADIUS of the density grid in
+// layout units.  Near a node K is close to the grid's fall off, but K
+// reaches across the whole plane, so clusters also push each other
+// apart from far away.  Tree cells smaller than theta times their
+// distance are summed as a single node at their center of mass.
+//
+// The fine density is that of DensityGrid (nodes in the 3 x 3 grid
+// cells around the point), found by searching the tree.
+
+#include <vector>
+
+using namespace std;
+
+#include "DensityServer.h"
+
+// a cell of the quadtree: a leaf holds a list of nodes, other cells
+// have four children (stored together, starting at child)
+
+struct TreeCell {
+  float cx, cy;				// center of mass
+  float mass;				// number of nodes in the cell
+  float size;
+  int child;				// -1 for a leaf
+  int head, count;			// node list of a leaf
+  int parent;
+  float x0, y0;				// square covered by the cell
+  double mx, my;			// sums of the nodes' x and y
+};
+
+class DensityTree : public DensityServer {
+
+public:
+
+	  // Methods
+	  void Init ( int num_nodes, int size = 0 );
+	  void Subtract(Node &n, bool first_add, bool fine_first_add, bool fineDensity);
+	  void Add(Node &n, bool fineDensity );
+	  void Move(Node &n, bool first_add, bool fine_first_add, bool fineDensity);
+	  float GetDensity(float Nx, float Ny, bool fineDensity, Node *self = NULL,
+					   long *scanned = NULL);
+	  void Rebuild ();
+
+	  // Batched updates used by the threaded engine.  The tree is not
+	  // split into bands of rows, so the thread owning row 0 applies
+	  // the whole batch.
+	  void Subtract(Node &n, bool first_add, bool fine_first_add,
+					bool fineDensity, int row_lo, int row_hi);
+	  void Add(Node &n, bool fineDensity, int row_lo, int row_hi);
+
+	  // checkpoints (the nodes are saved and the tree is rebuilt)
+	  void Write ( ostream &out );
+	  bool Read ( istream &in );
+
+	  // Contructor/Destructor
+	  DensityTree( float opening_angle ) : theta ( opening_angle ) {};
+	  ~DensityTree() {};
+
+private:
+
+	  // Private Members
+	  void Insert ( int id, float x, float y );
+	  void Remove ( int id );
+	  void Split ( int cell );
+	  void Gain ( TreeCell &cell, float x, float y, int sign );
+	  void Link ( int cell, int id );
+	  int Quadrant ( int cell, float x, float y );
+	  float Coarse ( float Nx, float Ny, long *scanned );
+	  double Fine ( float Nx, float Ny, int self_id, long *scanned );
+
+	  float theta;				// opening angle
+	  float kernel_scale;		// (2/R)^2, for K
+	  float min_size;			// size of a cell at TREE_MAX_DEPTH
+
+	  vector<TreeCell> cells;	// cells[0] is the root
+
+	  // nodes by id: position in the tree, leaf holding it (-1 if the
+	  // node is not in the tree) and neighbors in the leaf's list
+	  vector<float> node_x, node_y;
+	  vector<int> node_leaf, node_next, node_prev;
+};
+
+#endif // __DENSITY_TREE_H__
@@ -0,0 +1,360 @@
+// This file contains the member definitions of the EdgeFile.h classes
+
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+
+#ifdef _WIN32
+  #include <sys/stat.h>
+#else
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+using namespace std;
+
+#include <EdgeFile.h>
+
+EdgeFile::EdgeFile ( )
+{
+	map_base = NULL;
+	map_length = 0;
+	records = NULL;
+	offsets = NULL;
+	num_nodes = num_edges = -1;
+	next_record = 0;
+}
+
+// Open checks the first bytes of the file for the binary magic
+// string.  Binary files are mapped into memory, anything else is
+// read as text.  Returns false if the file can't be opened or is a
+// damaged binary file.
+
+bool EdgeFile::Open ( const char *file_name )
+{
+	Close ( );
+
+	FILE *fp = fopen ( file_name, "rb" );
+	if ( fp == NULL )
+		return false;
+	char magic[sizeof(EDGE_MAGIC)];
+	size_t got = fread ( magic, 1, sizeof(magic), fp );
+	fclose ( fp );
+
+	if ( (got == sizeof(magic)) && (memcmp ( magic, EDGE_MAGIC, sizeof(magic) ) == 0) )
+		return Map_Binary ( file_name );
+
+	return text.Open ( file_name );
+}
+
+bool EdgeFile::Map_Binary ( const char *file_name )
+{
+	struct stat file_stat;
+	if ( stat ( file_name, &file_stat ) != 0 )
+		return false;
+	map_length = file_stat.st_size;
+	if ( map_length < sizeof(EdgeHeader) )
+		return false;
+
+#ifdef _WIN32
+	// no mmap here, so read the whole file in
+	FILE *fp = fopen ( file_name, "rb" );
+	if ( fp == NULL )
+		return false;
+	map_base = (char *)malloc ( map_length );
+	if ( (map_base == NULL) || (fread ( map_base, 1, map_length, fp ) != map_length) )
+	{
+		fclose ( fp );
+		Close ( );
+		return false;
+	}
+	fclose ( fp );
+#else
+	int fd = open ( file_name, O_RDONLY );
+	if ( fd < 0 )
+		return false;
+	void *base = mmap ( NULL, map_length, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close ( fd );
+	if ( base == MAP_FAILED )
+		return false;
+	map_base = (char *)base;
+	madvise ( map_base, map_length, MADV_SEQUENTIAL );
+#endif
+
+	const EdgeHeader *header = (const EdgeHeader *)map_base;
+	num_nodes = header->num_nodes;
+	num_edges = header->num_edges;
+
+	// check that the counts agree with the size of the file
+	size_t need = sizeof(EdgeHeader) + num_edges*sizeof(EdgeRecord);
+	size_t offsets_start = (need + 7) & ~(size_t)7;
+	bool sorted = ( header->flags & EDGE_SORTED ) != 0;
+	if ( sorted )
+		need = offsets_start + (num_nodes+1)*sizeof(int64_t);
+	if ( (header->version != EDGE_VERSION) || (num_edges < 0) ||
+		 (num_nodes < 0) || (map_length < need) )
+	{
+		Close ( );
+		return false;
+	}
+
+	records = (const EdgeRecord *)(map_base + sizeof(EdgeHeader));
+	if ( sorted )
+		offsets = (const int64_t *)(map_base + offsets_start);
+	next_record = 0;
+	return true;
+}
+
+// Open ( edges ) reads the records of edges (which must be kept until
+// Close) as if they were a binary file.
+
+bool EdgeFile::Open ( const vector<EdgeRecord> &edges )
+{
+	static const EdgeRecord no_records[1] = { { 0, 0, 0.0 } };
+
+	Close ( );
+	records = edges.empty() ? no_records : edges.data();
+	num_edges = edges.size();
+	num_nodes = 0;
+	for ( long i = 0; i < num_edges; i++ )
+		num_nodes = max ( num_nodes, (long)max ( records[i].id1, records[i].id2 ) + 1 );
+	next_record = 0;
+	return true;
+}
+
+void EdgeFile::Close ( )
+{
+	if ( map_base != NULL )
+	{
+	#ifdef _WIN32
+		free ( map_base );
+	#else
+		munmap ( map_base, map_length );
+	#endif
+	}
+	map_base = NULL;
+	map_length = 0;
+	records = NULL;
+	offsets = NULL;
+	num_nodes = num_edges = -1;
+	next_record = 0;
+
+	text.Close ( );
+}
+
+// Rewind goes back to the first edge, for tools which scan a file
+// several times.
+
+void EdgeFile::Rewind ( )
+{
+	if ( Is_Binary() )
+		next_record = 0;
+	else
+		text.Rewind ( );
+}
+
+// Next returns the next edge in the file, or false at the end of the
+// file (or at the first line that can't be read as id id weight).
+
+bool EdgeFile::Next ( int &id1, int &id2, float &weight )
+{
+	if ( Is_Binary() )
+	{
+		if ( next_record >= num_edges )
+			return false;
+		const EdgeRecord &edge = records[next_record++];
+		id1 = edge.id1;
+		id2 = edge.id2;
+		weight = edge.weight;
+		return true;
+	}
+
+	return text.Read_Int ( id1 ) && text.Read_Int ( id2 ) &&
+		   text.Read_Float ( weight );
+}
+
+void EdgeBlock::Clear ( bool binary )
+{
+	this->binary = binary;
+	records.clear ( );
+	text.clear ( );
+	num_nodes = 0;
+}
+
+// Write adds an edge to the block.  Text lines are formatted as
+// EdgeWriter formats them (as by <<, six significant digits).
+
+void EdgeBlock::Write ( int id1, int id2, float weight )
+{
+	EdgeRecord edge;
+	edge.id1 = id1;
+	edge.id2 = id2;
+	edge.weight = weight;
+	records.push_back ( edge );
+	if ( id1 >= num_nodes ) num_nodes = id1 + 1;
+	if ( id2 >= num_nodes ) num_nodes = id2 + 1;
+
+	if ( !binary )
+	{
+		char number[32];
+		char *last = number + sizeof(number);
+		text.append ( number, to_chars ( number, last, id1 ).ptr );
+		text += '\t';
+		text.append ( number, to_chars ( number, last, id2 ).ptr );
+		text += '\t';
+		text.append ( number, to_chars ( number, last, weight, chars_format::general, 6 ).ptr );
+		text += '\n';
+	}
+}
+
+// Open the output file.  sorted (binary only) holds the edges until
+// Close, then writes them sorted by (id1, id2) with a row offset table.
+
+bool EdgeWriter::Open ( const char *file_name, bool binary, bool sorted )
+{
+	this->binary = binary;
+	this->sorted = binary && sorted;
+	memory = NULL;
+	held.clear ( );
+
+	if ( binary )
+		out.open ( file_name, ios::out | ios::binary );
+	else
+		out.open ( file_name );
+	if ( !out )
+		return false;
+
+	if ( binary )
+	{
+		memset ( &header, 0, sizeof(header) );
+		memcpy ( header.magic, EDGE_MAGIC, sizeof(header.magic) );
+		header.version = EDGE_VERSION;
+		header.flags = this->sorted ? EDGE_SORTED : 0;
+
+		// counts are filled in by Close
+		out.write ( (const char *)&header, sizeof(header) );
+	}
+	return (bool)out;
+}
+
+// Open ( edges ) writes the edges to the end of edges instead, as
+// records (edges is cleared first)
+
+bool EdgeWriter::Open ( vector<EdgeRecord> *edges )
+{
+	binary = true;
+	sorted = false;
+	memory = edges;
+	memory->clear ( );
+	return true;
+}
+
+void EdgeWriter::Write ( int id1, int id2, float weight )
+{
+	if ( !binary )
+	{
+		out << id1 << "\t" << id2 << "\t" << weight << "\n";
+		return;
+	}
+
+	EdgeRecord edge;
+	edge.id1 = id1;
+	edge.id2 = id2;
+	edge.weight = weight;
+
+	if ( memory != NULL )
+	{
+		memory->push_back ( edge );
+		return;
+	}
+
+	if ( id1 >= header.num_nodes ) header.num_nodes = id1 + 1;
+	if ( id2 >= header.num_nodes ) header.num_nodes = id2 + 1;
+	header.num_edges++;
+
+	if ( sorted )
+		held.push_back ( edge );
+	else
+		out.write ( (const char *)&edge, sizeof(edge) );
+}
+
+// Write ( block ) writes the edges of a block, as if each was written
+// in turn
+
+void EdgeWriter::Write ( const EdgeBlock &block )
+{
+	if ( !binary )
+	{
+		out.write ( block.text.data(), block.text.size() );
+		return;
+	}
+
+	if ( memory != NULL )
+	{
+		memory->insert ( memory->end(), block.records.begin(), block.records.end() );
+		return;
+	}
+
+	if ( block.num_nodes > header.num_nodes ) header.num_nodes = block.num_nodes;
+	header.num_edges += block.records.size();
+
+	if ( sorted )
+		held.insert ( held.end(), block.records.begin(), block.records.end() );
+	else
+		out.write ( (const char *)block.records.data(), block.records.size()*sizeof(EdgeRecord) );
+}
+
+static bool edge_record_less ( const EdgeRecord &a, const EdgeRecord &b )
+{
+	if ( a.id1 != b.id1 ) return a.id1 < b.id1;
+	return a.id2 < b.id2;
+}
+
+void EdgeWriter::Write_Sorted ( )
+{
+	stable_sort ( held.begin(), held.end(), edge_record_less );
+	out.write ( (const char *)held.data(), held.size()*sizeof(EdgeRecord) );
+
+	// pad to 8 bytes, then the row offsets
+	size_t end = sizeof(EdgeHeader) + held.size()*sizeof(EdgeRecord);
+	char pad[8] = { 0 };
+	out.write ( pad, ((end + 7) & ~(size_t)7) - end );
+
+	vector<int64_t> offset ( header.num_nodes + 1, 0 );
+	for ( size_t i = 0; i < held.size(); i++ )
+		offset[held[i].id1+1]++;
+	for ( long i = 0; i < header.num_nodes; i++ )
+		offset[i+1] += offset[i];
+	out.write ( (const char *)offset.data(), offset.size()*sizeof(int64_t) );
+
+	held.clear ( );
+}
+
+// Close finishes the file; for binary files the header is rewritten
+// with the final counts.  Returns false if any write failed.
+
+bool EdgeWriter::Close ( )
+{
+	if ( memory != NULL )
+	{
+		memory = NULL;
+		return true;
+	}
+
+	if ( binary )
+	{
+		if ( sorted )
+			Write_Sorted ( );
+		out.seekp ( 0 );
+		out.write ( (const char *)&header, sizeof(header) );
+	}
+	bool ok = (bool)out;
+	out.close ( );
+	return ok && !out.fail();
+}
@@ -0,0 +1,143 @@
+#ifndef __EDGE_FILE_H__
+#define __EDGE_FILE_H__
+
+// Edge files hold a weighted graph as (id, id, weight) triples.  The
+// .int and .full files can be written either as text, one
+//
+//	id <tab> id <tab> weight
+//
+// per line, or in a binary form which is mapped straight into memory
+// instead of being parsed.  A binary edge file is laid out as
+//
+//	EdgeHeader		magic, version, flags, node and edge counts
+//	EdgeRecord		num_edges records (int32 id, int32 id, float32 weight)
+//	int64			num_nodes+1 row offsets (only if EDGE_SORTED is set)
+//
+// in the byte order of the machine that wrote it.  When EDGE_SORTED
+// is set the records are sorted by (id1, id2) and the edges of node i
+// are records offset[i] to offset[i+1]-1.  The offset table starts on
+// an 8 byte boundary.
+//
+// EdgeFile reads either format (the format is detected from the first
+// bytes of the file) and EdgeWriter writes either format.  Both can
+// also be opened on a vector of records in memory, so a graph can be
+// passed between the stages of openord_multilevel without a file, and
+// read and written as if it were a binary file.  An EdgeBlock
+// holds edges ready to be written, so that several threads can each
+// fill a block and the blocks be written in order.
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+#include <TextReader.h>
+
+#define EDGE_MAGIC "DrLedge"	// 8 bytes, including terminating 0
+#define EDGE_VERSION 1
+
+#define EDGE_SORTED 1			// records sorted, offset table present
+
+struct EdgeHeader {
+	char magic[8];
+	int32_t version;
+	int32_t flags;
+	int64_t num_nodes;			// largest id + 1
+	int64_t num_edges;
+};
+
+struct EdgeRecord {
+	int32_t id1;
+	int32_t id2;
+	float weight;
+};
+
+class EdgeFile {
+
+public:
+
+	// Methods
+	bool Open ( const char *file_name );
+	bool Open ( const vector<EdgeRecord> &edges );
+	void Close ( );
+	void Rewind ( );
+	bool Next ( int &id1, int &id2, float &weight );
+
+	bool Is_Binary ( ) const { return records != NULL; }
+	bool Is_Sorted ( ) const { return offsets != NULL; }
+	long Num_Nodes ( ) const { return num_nodes; }
+	long Num_Edges ( ) const { return num_edges; }
+	const EdgeRecord *Records ( ) const { return records; }
+	const int64_t *Row_Offsets ( ) const { return offsets; }
+
+	// Con/Decon
+	EdgeFile ( );
+	~EdgeFile ( ) { Close ( ); }
+
+private:
+
+	bool Map_Binary ( const char *file_name );
+
+	TextReader text;				// text input
+	char *map_base;					// binary input (whole file)
+	size_t map_length;
+	const EdgeRecord *records;
+	const int64_t *offsets;
+	long num_nodes, num_edges;		// -1 for text files
+	long next_record;
+};
+
+class EdgeBlock {
+
+public:
+
+	// Methods
+	void Clear ( bool binary );
+	void Write ( int id1, int id2, float weight );
+	long Num_Edges ( ) const { return records.size(); }
+	const EdgeRecord *Records ( ) const { return records.data(); }
+
+	// Con/Decon
+	EdgeBlock ( ) : binary ( false ), num_nodes ( 0 ) { }
+	~EdgeBlock ( ) { }
+
+private:
+
+	friend class EdgeWriter;
+
+	bool binary;
+	vector<EdgeRecord> records;
+	string text;					// records as lines of a text file
+	long num_nodes;					// largest id + 1
+};
+
+class EdgeWriter {
+
+public:
+
+	// Methods
+	bool Open ( const char *file_name, bool binary, bool sorted = false );
+	bool Open ( vector<EdgeRecord> *edges );
+	void Write ( int id1, int id2, float weight );
+	void Write ( const EdgeBlock &block );
+	bool Close ( );
+	bool Is_Binary ( ) const { return binary; }
+
+	// Con/Decon
+	EdgeWriter ( ) : binary ( false ), sorted ( false ), memory ( NULL ) { }
+	~EdgeWriter ( ) { if ( out.is_open() ) Close ( ); }
+
+private:
+
+	void Write_Sorted ( );
+
+	ofstream out;
+	bool binary, sorted;
+	EdgeHeader header;
+	vector<EdgeRecord> held;		// records waiting to be sorted
+	vector<EdgeRecord> *memory;		// records written to memory, if not NULL
+};
+
+#endif // __EDGE_FILE_H__
@@ -0,0 +1,231 @@
+// This file contains the methods for EdgeRuns.h
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+
+using namespace std;
+
+#include <EdgeRuns.h>
+
+// EdgeRuns with run files on disk, removed at exit (exit(1) on an
+// error skips the destructors)
+
+static vector<EdgeRuns *> spilled_runs;
+
+static void remove_spilled_runs ( )
+{
+  while ( !spilled_runs.empty() )
+    spilled_runs.back()->Remove ( );
+}
+
+static bool record_less ( const EdgeRecord &a, const EdgeRecord &b )
+{
+  return ( a.id1 < b.id1 ) || ( a.id1 == b.id1 && a.id2 < b.id2 );
+}
+
+void EdgeRuns::Start ( string run_root, long run_edges )
+{
+  root = run_root;
+  this->run_edges = run_edges;
+  num_edges = 0;
+  held.reserve ( min ( run_edges, 1L << 20 ) );
+}
+
+void EdgeRuns::Add ( const EdgeRecord &forward )
+{
+  EdgeRecord backward;
+  backward.id1 = forward.id2;
+  backward.id2 = forward.id1;
+  backward.weight = forward.weight;
+  held.push_back ( forward );
+  held.push_back ( backward );
+  if ( (long)held.size() >= run_edges )
+    Spill ( );
+  num_edges++;
+}
+
+// Finish sorts the last records, after all the edges have been added
+
+void EdgeRuns::Finish ( )
+{
+  cout << "Sorting edges ..." << endl;
+  if ( runs.empty() )
+    stable_sort ( held.begin(), held.end(), record_less );
+  else if ( !held.empty() )
+    Spill ( );
+  cout << "Sorted " << num_edges << " edges";
+  if ( !runs.empty() )
+    cout << " in " << runs.size() << " runs";
+  cout << "." << endl;
+  
+  // the runs share run_edges records of buffer
+  if ( !runs.empty() )
+    buffer_size = max ( run_edges / (long)runs.size(), 1024L );
+  Rewind ( );
+}
+
+// Spill sorts the records held and writes them to the next run file
+
+void EdgeRuns::Spill ( )
+{
+  stable_sort ( held.begin(), held.end(), record_less );
+  
+  if ( runs.empty() )
+  {
+    static bool registered = false;
+    if ( !registered )
+      atexit ( remove_spilled_runs );
+    registered = true;
+    spilled_runs.push_back ( this );
+  }
+  
+  ostringstream file_name;
+  file_name << root << runs.size();
+  Run *run = new Run;
+  run->file_name = file_name.str();
+  run->length = held.size();
+  runs.push_back ( run );
+  
+  ofstream out ( run->file_name.c_str(), ios::binary );
+  out.write ( (const char *)held.data(), held.size()*sizeof(EdgeRecord) );
+  out.close ();
+  if ( !out )
+  {
+    cout << "Error: could not write " << run->file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  held.clear ();
+}
+
+// Rewind starts the rows again from the first
+
+void EdgeRuns::Rewind ( )
+{
+  held_next = 0;
+  heads = priority_queue<Head> ();
+  if ( runs.empty() )
+    return;
+  
+  for ( unsigned int r = 0; r < runs.size(); r++ )
+  {
+    Run *run = runs[r];
+    run->in.close ();
+    run->in.clear ();
+    run->in.open ( run->file_name.c_str(), ios::binary );
+    if ( !run->in )
+    {
+      cout << "Error: could not open " << run->file_name << ".  Program terminated." << endl;
+      exit(1);
+    }
+    run->left = run->length;
+    run->buffer.clear ();
+    run->next = 0;
+    if ( Fill ( r ) )
+      Push ( r );
+  }
+}
+
+// Fill reads the next buffer of a run (false at the end of the run)
+
+bool EdgeRuns::Fill ( int r )
+{
+  Run *run = runs[r];
+  if ( run->left == 0 )
+    return false;
+  
+  long length = min ( run->left, buffer_size );
+  run->buffer.resize ( length );
+  run->in.read ( (char *)run->buffer.data(), length*sizeof(EdgeRecord) );
+  if ( !run->in )
+  {
+    cout << "Error: could not read " << run->file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  run->left -= length;
+  run->next = 0;
+  return true;
+}
+
+// Push puts the next record of a run on the heap
+
+void EdgeRuns::Push ( int r )
+{
+  Head head;
+  head.record = runs[r]->buffer[runs[r]->next];
+  head.run = r;
+  heads.push ( head );
+}
+
+// add_column adds a record to its row (a column already there takes
+// the later weight)
+
+static void add_column ( const EdgeRecord &record, vector<int> &columns, vector<float> &weights )
+{
+  if ( !columns.empty() && columns.back() == record.id2 )
+    weights.back() = record.weight;
+  else
+  {
+    columns.push_back ( record.id2 );
+    weights.push_back ( record.weight );
+  }
+}
+
+// Next_Row returns the next row, its columns in increasing order.  A
+// column given more than once takes its last weight in the .full file
+// (as the old map of rows did).
+
+bool EdgeRuns::Next_Row ( int &row, vector<int> &columns, vector<float> &weights )
+{
+  columns.clear ();
+  weights.clear ();
+  
+  // one run, in memory
+  if ( runs.empty() )
+  {
+    if ( held_next >= held.size() )
+      return false;
+    row = held[held_next].id1;
+    for ( ; held_next < held.size() && held[held_next].id1 == row; held_next++ )
+      add_column ( held[held_next], columns, weights );
+    return true;
+  }
+  
+  if ( heads.empty() )
+    return false;
+  
+  row = heads.top().record.id1;
+  while ( !heads.empty() && heads.top().record.id1 == row )
+  {
+    Head head = heads.top();
+    heads.pop();
+    add_column ( head.record, columns, weights );
+    
+    Run *run = runs[head.run];
+    run->next++;
+    if ( run->next < run->buffer.size() || Fill ( head.run ) )
+      Push ( head.run );
+  }
+  return true;
+}
+
+// Remove deletes the run files
+
+void EdgeRuns::Remove ( )
+{
+  for ( unsigned int r = 0; r < runs.size(); r++ )
+  {
+    runs[r]->in.close ();
+    remove ( runs[r]->file_name.c_str() );
+    delete runs[r];
+  }
+  runs.clear ();
+  spilled_runs.erase ( remove ( spilled_runs.begin(), spilled_runs.end(), this ),
+                       spilled_runs.end() );
+}
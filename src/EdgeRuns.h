@@ -0,0 +1,78 @@
+#ifndef __EDGE_RUNS_H__
+#define __EDGE_RUNS_H__
+
+// EdgeRuns sorts the edges of a .full graph out of core for truncate,
+// so each row of the graph can be streamed in order with bounded
+// memory.  Edges are added in the order of the file, and each
+// edge is kept from both ends as a (row, column, weight) record.
+// Every run_edges records are sorted by row and column (stably, so a
+// repeated edge keeps its place in the file) and written to a
+// temporary run file, run_root<k>.  Rows are then read by merging the
+// runs, as often as needed.  If the whole file fits in one run it is
+// kept in memory and nothing is written.  The run files are removed by
+// Remove, or at exit if the program stops on an error.
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <queue>
+
+using namespace std;
+
+#include <EdgeFile.h>
+
+class EdgeRuns {
+
+public:
+
+	// Methods
+	void Start ( string run_root, long run_edges );
+	void Add ( const EdgeRecord &edge );
+	void Finish ( );
+	void Rewind ( );
+	bool Next_Row ( int &row, vector<int> &columns, vector<float> &weights );
+	void Remove ( );
+
+	// Con/Decon
+	EdgeRuns ( ) : run_edges ( 0 ), num_edges ( 0 ), held_next ( 0 ), buffer_size ( 0 ) { }
+	~EdgeRuns ( ) { Remove ( ); }
+
+private:
+
+	// a run being merged, read buffer_size records at a time
+	struct Run {
+	  string file_name;
+	  ifstream in;
+	  vector<EdgeRecord> buffer;
+	  size_t next;
+	  long left;				// records not yet read from the file
+	  long length;
+	};
+
+	void Spill ( );
+	bool Fill ( int run );
+	void Push ( int run );
+
+	string root;
+	long run_edges, num_edges;
+	vector<EdgeRecord> held;	// records of the run being built
+	size_t held_next;			// (next record, with one run)
+	vector<Run *> runs;
+	long buffer_size;
+
+	// merge heap: the next record of each run, least (row, column, run)
+	// at the front
+	struct Head {
+	  EdgeRecord record;
+	  int run;
+	  bool operator< ( const Head &other ) const
+	  {
+		if ( record.id1 != other.record.id1 ) return record.id1 > other.record.id1;
+		if ( record.id2 != other.record.id2 ) return record.id2 > other.record.id2;
+		return run > other.run;
+	  }
+	};
+	priority_queue<Head> heads;
+};
+
+#endif // __EDGE_RUNS_H__
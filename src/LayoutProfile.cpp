@@ -0,0 +1,47 @@
+// This file contains the methods for the LayoutProfile.h class
+
+#include <iostream>
+
+using namespace std;
+
+#include <LayoutProfile.h>
+
+// column names of the .prof file, in the order of the enums
+static const char *timer_names[NUM_PROF_TIMERS] = {
+	"solve_analytic", "edge_energy", "density", "density_update", "wait" };
+static const char *count_names[NUM_PROF_COUNTS] = {
+	"nodes", "edges", "cuts", "density_queries", "bins", "allgather_bytes" };
+
+void LayoutProfile::Clear ( )
+{
+	for ( int i = 0; i < NUM_PROF_TIMERS; i++ )
+	  time[i] = 0;
+	for ( int i = 0; i < NUM_PROF_COUNTS; i++ )
+	  count[i] = 0;
+}
+
+void LayoutProfile::Add ( const LayoutProfile &other )
+{
+	for ( int i = 0; i < NUM_PROF_TIMERS; i++ )
+	  time[i] += other.time[i];
+	for ( int i = 0; i < NUM_PROF_COUNTS; i++ )
+	  count[i] += other.count[i];
+}
+
+// Write puts out the timers then the counters, comma separated
+
+void LayoutProfile::Write ( ostream &out ) const
+{
+	for ( int i = 0; i < NUM_PROF_TIMERS; i++ )
+	  out << ( i ? "," : "" ) << time[i];
+	for ( int i = 0; i < NUM_PROF_COUNTS; i++ )
+	  out << "," << count[i];
+}
+
+void LayoutProfile::Write_Header ( ostream &out )
+{
+	for ( int i = 0; i < NUM_PROF_TIMERS; i++ )
+	  out << ( i ? "," : "" ) << timer_names[i];
+	for ( int i = 0; i < NUM_PROF_COUNTS; i++ )
+	  out << "," << count_names[i];
+}
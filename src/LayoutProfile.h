@@ -0,0 +1,87 @@
+#ifndef __LAYOUT_PROFILE_H__
+#define __LAYOUT_PROFILE_H__
+
+// The LayoutProfile class holds the timers and counters of one thread
+// of layout for one iteration (layout -m).  graph keeps a profile per
+// thread and, after each iteration, writes their totals over threads
+// and procs as a line of the .prof file (comma separated).  When
+// profiling is off graph hands out NULL profiles, so each probe costs
+// a single test.
+
+#include <chrono>
+#include <ostream>
+
+using namespace std;
+
+// timers, in seconds
+enum {
+	PROF_SOLVE,			// Solve_Analytic (centroids and edge cutting)
+	PROF_EDGE_ENERGY,	// attraction part of the node energies
+	PROF_DENSITY,		// density queries
+	PROF_UPDATE,		// density adds, subtracts, moves and rebuilds
+	PROF_WAIT,			// MPI position exchanges and thread barriers
+	NUM_PROF_TIMERS
+};
+
+// counters
+enum {
+	PROF_NODES,			// nodes moved
+	PROF_EDGES,			// edges visited
+	PROF_CUTS,			// edges cut
+	PROF_QUERIES,		// density queries
+	PROF_BINS,			// density grid bins (or tree cells) scanned
+	PROF_BYTES,			// bytes received by MPI_Allgather
+	NUM_PROF_COUNTS
+};
+
+class LayoutProfile {
+
+public:
+
+	// Methods
+	void Clear ( );
+	void Add ( const LayoutProfile &other );
+	void Write ( ostream &out ) const;
+	static void Write_Header ( ostream &out );
+
+	// seconds on a steady clock
+	static double Now ( )
+	{
+		return chrono::duration<double> (
+			chrono::steady_clock::now ( ).time_since_epoch ( ) ).count ( );
+	}
+
+	double time[NUM_PROF_TIMERS];
+	long count[NUM_PROF_COUNTS];
+
+	// Con/Decon
+	LayoutProfile ( ) { Clear ( ); }
+	~LayoutProfile ( ) { }
+};
+
+// A ProfileTimer adds the time until it goes out of scope to one
+// timer of a profile (nothing is timed for a NULL profile)
+
+class ProfileTimer {
+
+public:
+
+	ProfileTimer ( LayoutProfile *prof, int which ) : profile ( prof ), timer ( which )
+	{
+		if ( profile )
+		  start = LayoutProfile::Now ( );
+	}
+	~ProfileTimer ( )
+	{
+		if ( profile )
+		  profile->time[timer] += LayoutProfile::Now ( ) - start;
+	}
+
+private:
+
+	LayoutProfile *profile;
+	int timer;
+	double start;
+};
+
+#endif // __LAYOUT_PROFILE_H__
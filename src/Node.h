@@ -21,7 +21,7 @@ class Node {
 
  public:
   
-  Node( int node_id ) { x = y = 0.0; fixed = false; 
+  Node( int node_id ) { x = y = 0.0; energy = 0.0; fixed = false; 
 						id = node_id; }
   ~Node() { }
   
@@ -0,0 +1,63 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+// The CounterRng class gives the random numbers of the layout engine.
+// It is the Philox4x32-10 counter based generator (Salmon et al.,
+// "Parallel Random Numbers: As Easy as 1, 2, 3", SC11): the numbers
+// are a pure function of a key (the random seed) and a counter, here
+// (iteration, node id).  A node's random jump is therefore the same
+// whichever proc or thread moves it, in whatever order, and nothing
+// has to be drawn just to keep procs in step.
+
+#include <stdint.h>
+
+class CounterRng {
+
+public:
+
+	// four random words for the counter (c0, c1, c2, c3)
+	void Generate ( uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3,
+					uint32_t out[4] ) const
+	{
+		uint32_t k0 = key0, k1 = key1;
+		for ( int round = 0; round < 10; round++ )
+		{
+			if ( round > 0 )
+			{
+				k0 += 0x9E3779B9;
+				k1 += 0xBB67AE85;
+			}
+			uint64_t p0 = (uint64_t)0xD2511F53 * c0;
+			uint64_t p1 = (uint64_t)0xCD9E8D57 * c2;
+			uint32_t n0 = (uint32_t)( p1 >> 32 ) ^ c1 ^ k0;
+			uint32_t n2 = (uint32_t)( p0 >> 32 ) ^ c3 ^ k1;
+			c0 = n0;
+			c1 = (uint32_t)p1;
+			c2 = n2;
+			c3 = (uint32_t)p0;
+		}
+		out[0] = c0;
+		out[1] = c1;
+		out[2] = c2;
+		out[3] = c3;
+	}
+
+	// two uniform floats in [0,1) for (iteration, node)
+	void Uniform ( int iteration, int node, float &u0, float &u1 ) const
+	{
+		uint32_t out[4];
+		Generate ( (uint32_t)iteration, (uint32_t)node, 0, 0, out );
+		u0 = ( out[0] >> 8 ) * ( 1.0f / 16777216.0f );
+		u1 = ( out[1] >> 8 ) * ( 1.0f / 16777216.0f );
+	}
+
+	// Con/Decon
+	CounterRng ( uint32_t seed = 0, uint32_t stream = 0 ) : key0 ( seed ), key1 ( stream ) { }
+	~CounterRng ( ) { }
+
+private:
+
+	uint32_t key0, key1;
+};
+
+#endif // __RNG_H__
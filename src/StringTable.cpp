@@ -0,0 +1,102 @@
+// This file contains the member definitions of the StringTable.h class
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include <StringTable.h>
+
+#define STRING_TABLE_SLOTS 1024		// initial slots (a power of 2)
+
+void StringTable::Clear ( )
+{
+	arena.clear ( );
+	offsets.clear ( );
+	lengths.clear ( );
+	hashes.clear ( );
+	slots.assign ( STRING_TABLE_SLOTS, -1 );
+	mask = STRING_TABLE_SLOTS - 1;
+}
+
+// Hash is 64 bit FNV-1a
+
+uint64_t StringTable::Hash ( string_view s )
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for ( size_t i = 0; i < s.size(); i++ )
+	{
+		hash ^= (unsigned char)s[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Add returns the index of s, adding it if it is new (added is set
+// true if so).  hash must be Hash ( s ).
+
+int StringTable::Add ( string_view s, uint64_t hash, bool &added )
+{
+	uint64_t slot = hash & mask;
+	for ( ; slots[slot] >= 0; slot = (slot + 1) & mask )
+	{
+		int index = slots[slot];
+		if ( (hashes[index] == hash) && (String ( index ) == s) )
+		{
+			added = false;
+			return index;
+		}
+	}
+
+	int index = Size();
+	offsets.push_back ( arena.size() );
+	lengths.push_back ( s.size() );
+	hashes.push_back ( hash );
+	arena.insert ( arena.end(), s.begin(), s.end() );
+	slots[slot] = index;
+	added = true;
+
+	// keep the table at most half full
+	if ( 2 * (uint64_t)Size() > slots.size() )
+		Grow ( );
+	return index;
+}
+
+// Find returns the index of s, -1 if it has not been added
+
+int StringTable::Find ( string_view s, uint64_t hash ) const
+{
+	for ( uint64_t slot = hash & mask; slots[slot] >= 0; slot = (slot + 1) & mask )
+	{
+		int index = slots[slot];
+		if ( (hashes[index] == hash) && (String ( index ) == s) )
+			return index;
+	}
+	return -1;
+}
+
+// Grow doubles the slots and puts the strings back in them
+
+void StringTable::Grow ( )
+{
+	slots.assign ( 2 * slots.size(), -1 );
+	mask = slots.size() - 1;
+	for ( int index = 0; index < Size(); index++ )
+	{
+		uint64_t slot = hashes[index] & mask;
+		while ( slots[slot] >= 0 )
+			slot = (slot + 1) & mask;
+		slots[slot] = index;
+	}
+}
+
+void StringTable::Sorted_Order ( vector<int> &order ) const
+{
+	order.resize ( Size() );
+	for ( int index = 0; index < Size(); index++ )
+		order[index] = index;
+	sort ( order.begin(), order.end(),
+		   [this]( int a, int b ) { return String ( a ) < String ( b ); } );
+}
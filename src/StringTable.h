@@ -0,0 +1,56 @@
+#ifndef __STRING_TABLE_H__
+#define __STRING_TABLE_H__
+
+// The StringTable class interns the string ids of the DrL tools: each
+// distinct string added gets an index (0, 1, 2, ... in the order the
+// strings were first added), and the index of a string is found again
+// by hashing.  The strings are copied end to end into one arena and
+// the table is open addressing with linear probing, so adding and
+// finding ids make no allocation per string and no string compares
+// beyond the one that matches.
+//
+// Sorted_Order gives the indices in sorted string order (the order of
+// a map<string,...>), for numbering ids deterministically.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+class StringTable {
+
+public:
+
+	// Methods
+	int Add ( string_view s, bool &added ) { return Add ( s, Hash ( s ), added ); }
+	int Add ( string_view s, uint64_t hash, bool &added );
+	int Find ( string_view s ) const { return Find ( s, Hash ( s ) ); }
+	int Find ( string_view s, uint64_t hash ) const;
+	void Clear ( );
+
+	int Size ( ) const { return lengths.size(); }
+	string_view String ( int index ) const
+		{ return string_view ( arena.data() + offsets[index], lengths[index] ); }
+	void Sorted_Order ( vector<int> &order ) const;
+
+	static uint64_t Hash ( string_view s );
+
+	// Con/Decon
+	StringTable ( ) { Clear ( ); }
+	~StringTable ( ) { }
+
+private:
+
+	void Grow ( );
+
+	vector<char> arena;				// the strings, end to end
+	vector<long> offsets;			// string i is at arena[offsets[i]] ...
+	vector<int> lengths;
+	vector<uint64_t> hashes;
+	vector<int> slots;				// index of a string, -1 if empty
+	uint64_t mask;					// slots.size() - 1
+};
+
+#endif // __STRING_TABLE_H__
@@ -0,0 +1,204 @@
+// This file contains the member definitions of the TextReader.h class
+
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include <TextReader.h>
+
+#ifndef O_BINARY
+  #define O_BINARY 0
+#endif
+
+static inline bool is_space ( char c )
+{
+	return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') ||
+		   (c == '\v') || (c == '\f');
+}
+
+bool TextReader::Open ( const char *file_name, long offset, long length )
+{
+	Close ( );
+	fd = open ( file_name, O_RDONLY | O_BINARY );
+	if ( fd < 0 )
+		return false;
+	buffer.resize ( TEXT_BLOCK );
+	this->offset = offset;
+	this->length = length;
+	Rewind ( );
+	return true;
+}
+
+void TextReader::Close ( )
+{
+	if ( fd >= 0 )
+		close ( fd );
+	fd = -1;
+	start = end = 0;
+	at_eof = false;
+}
+
+void TextReader::Rewind ( )
+{
+	if ( fd < 0 )
+		return;
+	lseek ( fd, offset, SEEK_SET );
+	start = end = 0;
+	at_eof = false;
+	left = length;
+}
+
+// Fill moves the unread bytes to the front of the buffer and reads
+// another block after them (growing the buffer if a single token is
+// longer than a block).  Returns false if nothing more could be read.
+
+bool TextReader::Fill ( )
+{
+	if ( at_eof || (fd < 0) )
+		return false;
+
+	if ( start > 0 )
+	{
+		memmove ( buffer.data(), buffer.data() + start, end - start );
+		end -= start;
+		start = 0;
+	}
+	if ( end == buffer.size() )
+		buffer.resize ( 2*buffer.size() );
+
+	size_t want = buffer.size() - end;
+	if ( (left >= 0) && ((long)want > left) )
+		want = left;
+
+	ssize_t got = 0;
+	if ( want > 0 )
+		do
+			got = read ( fd, buffer.data() + end, want );
+		while ( (got < 0) && (errno == EINTR) );
+
+	if ( got <= 0 )
+	{
+		at_eof = true;
+		return false;
+	}
+	end += got;
+	if ( left >= 0 )
+		left -= got;
+	return true;
+}
+
+// Skip_Space moves past whitespace, returns false at end of file
+
+bool TextReader::Skip_Space ( )
+{
+	for ( ;; )
+	{
+		while ( (start < end) && is_space ( buffer[start] ) )
+			start++;
+		if ( start < end )
+			return true;
+		if ( !Fill ( ) )
+			return false;
+	}
+}
+
+// Token_End returns the end of the token starting at start, reading
+// more of the file if the token runs off the end of the buffer.  A
+// field ends at a tab or end of line, anything else at whitespace.
+
+size_t TextReader::Token_End ( bool field )
+{
+	size_t pos = start;
+	for ( ;; )
+	{
+		if ( field )
+			while ( (pos < end) && (buffer[pos] != '\t') &&
+					(buffer[pos] != '\n') && (buffer[pos] != '\r') )
+				pos++;
+		else
+			while ( (pos < end) && !is_space ( buffer[pos] ) )
+				pos++;
+		if ( pos < end )
+			return pos;
+
+		// Fill moves the token to the front of the buffer
+		size_t scanned = pos - start;
+		if ( !Fill ( ) )
+			return end;
+		pos = start + scanned;
+	}
+}
+
+// Read_Int and Read_Float parse the number at the start of the next
+// token (like >>, a leading + is allowed and parsing stops at the
+// first character which is not part of the number).  Numbers out of
+// range are kept as strtol and strtof keep them: ints are clamped to
+// INT_MIN or INT_MAX, floats too small become 0 and floats too large
+// become +/-inf.
+
+bool TextReader::Read_Int ( int &value )
+{
+	if ( !Skip_Space ( ) )
+		return false;
+	size_t stop = Token_End ( false );
+	const char *first = buffer.data() + start;
+	const char *last = buffer.data() + stop;
+	if ( (*first == '+') && (last - first > 1) && (first[1] != '-') )
+		first++;
+	from_chars_result result = from_chars ( first, last, value );
+	if ( result.ec == errc::result_out_of_range )
+		value = (*first == '-') ? INT_MIN : INT_MAX;
+	else if ( result.ec != errc() )
+		return false;
+	start = result.ptr - buffer.data();
+	return true;
+}
+
+bool TextReader::Read_Float ( float &value )
+{
+	if ( !Skip_Space ( ) )
+		return false;
+	size_t stop = Token_End ( false );
+	const char *first = buffer.data() + start;
+	const char *last = buffer.data() + stop;
+	if ( (*first == '+') && (last - first > 1) && (first[1] != '-') )
+		first++;
+	from_chars_result result = from_chars ( first, last, value );
+	if ( result.ec == errc::result_out_of_range )
+		value = strtof ( string ( first, result.ptr ).c_str(), NULL );
+	else if ( result.ec != errc() )
+		return false;
+	start = result.ptr - buffer.data();
+	return true;
+}
+
+// Read_Word and Read_Field reuse the storage already held by the
+// string, so reading into the same string does not allocate.
+
+bool TextReader::Read_Word ( string &word )
+{
+	if ( !Skip_Space ( ) )
+		return false;
+	size_t stop = Token_End ( false );
+	word.assign ( buffer.data() + start, stop - start );
+	start = stop;
+	return true;
+}
+
+bool TextReader::Read_Field ( string &field )
+{
+	if ( !Skip_Space ( ) )
+		return false;
+	size_t stop = Token_End ( true );
+	field.assign ( buffer.data() + start, stop - start );
+	start = stop;
+	return true;
+}
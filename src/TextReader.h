@@ -0,0 +1,62 @@
+#ifndef __TEXT_READER_H__
+#define __TEXT_READER_H__
+
+// The TextReader class reads the whitespace separated text files used
+// by the DrL tools (.sim, .int, .full, .coord, .clust, .ind, ...).  The
+// file is read in large blocks with read() and numbers are converted
+// in place with from_chars, so there is no per-line allocation or
+// stream overhead.  The Read_ methods behave like the >> operator:
+// they skip leading whitespace, return false at the end of the file or
+// if the next token is not of the requested type, so files are read with
+//
+//	while ( in.Read_Int ( id1 ) && in.Read_Int ( id2 ) && in.Read_Float ( w ) )
+//
+// and a trailing newline (or a missing one) needs no special handling.
+//
+// A reader can also be opened on length bytes of a file from offset,
+// which it reads as if they were the whole file, so several threads can
+// each read a part of the same file.
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#define TEXT_BLOCK 1048576		// bytes read from the file at a time
+
+class TextReader {
+
+public:
+
+	// Methods
+	bool Open ( const char *file_name, long offset = 0, long length = -1 );
+	void Close ( );
+	void Rewind ( );
+	bool Is_Open ( ) const { return fd >= 0; }
+	bool At_End ( ) { return !Skip_Space ( ); }		// only whitespace left
+
+	bool Read_Int ( int &value );
+	bool Read_Float ( float &value );
+	bool Read_Word ( string &word );		// up to the next whitespace
+	bool Read_Field ( string &field );		// up to the next tab or end of line
+
+	// Con/Decon
+	TextReader ( ) : fd ( -1 ), start ( 0 ), end ( 0 ), at_eof ( false ),
+					 offset ( 0 ), length ( -1 ), left ( -1 ) { }
+	~TextReader ( ) { Close ( ); }
+
+private:
+
+	bool Fill ( );
+	bool Skip_Space ( );
+	size_t Token_End ( bool field );
+
+	int fd;
+	vector<char> buffer;
+	size_t start, end;			// unread bytes are buffer[start, end)
+	bool at_eof;				// no more to read() from the file
+	long offset, length;		// the part of the file read (length -1 for all)
+	long left;					// bytes of the part not yet read
+};
+
+#endif // __TEXT_READER_H__
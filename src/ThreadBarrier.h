@@ -0,0 +1,44 @@
+#ifndef __THREAD_BARRIER_H__
+#define __THREAD_BARRIER_H__
+
+// The ThreadBarrier class holds the worker threads of the threaded
+// layout engine together between the phases of a batch.  The phases
+// are short, so waiting threads spin for a while before yielding.
+
+#include <atomic>
+#include <thread>
+
+class ThreadBarrier {
+
+public:
+
+	// Methods
+	void Wait ( )
+	{
+		int gen = generation.load ( );
+		if ( waiting.fetch_add ( 1 ) + 1 == num_threads )
+		{
+			waiting.store ( 0 );
+			generation.fetch_add ( 1 );
+		}
+		else
+		{
+			int spins = 0;
+			while ( generation.load ( ) == gen )
+				if ( ++spins > 1000 )
+					std::this_thread::yield ( );
+		}
+	}
+
+	// Con/Decon
+	ThreadBarrier ( int count ) : num_threads ( count ), waiting ( 0 ), generation ( 0 ) { }
+	~ThreadBarrier ( ) { }
+
+private:
+
+	int num_threads;
+	std::atomic<int> waiting;
+	std::atomic<int> generation;
+};
+
+#endif // __THREAD_BARRIER_H__
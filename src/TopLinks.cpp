@@ -0,0 +1,116 @@
+// This file contains the methods for TopLinks.h
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+#include <TopLinks.h>
+
+void TopLinks::Clear ( )
+{
+	rows.clear ();
+	num_top.clear ();
+	columns.clear ();
+	weights.clear ();
+	top.clear ();
+	row_start.resize ( 1 );
+	top_start.resize ( 1 );
+}
+
+// Add_Row adds the links of a row to the batch, to keep the top n
+
+void TopLinks::Add_Row ( int row, const vector<int> &columns, const vector<float> &weights,
+						 int n )
+{
+	int degree = columns.size();
+	int num_out = max ( 0, min ( n, degree ) );
+
+	rows.push_back ( row );
+	num_top.push_back ( num_out );
+	this->columns.insert ( this->columns.end(), columns.begin(), columns.end() );
+	this->weights.insert ( this->weights.end(), weights.begin(), weights.end() );
+	row_start.push_back ( this->columns.size() );
+	top_start.push_back ( top_start.back() + num_out );
+}
+
+// Write normalizes (if denoms is given, by sqrt(denoms[row]*denoms[column]))
+// and selects the top links of every row in the batch, writes them
+// to out and clears the batch
+
+void TopLinks::Write ( EdgeWriter &out, int num_threads, const vector<float> *denoms )
+{
+	top.resize ( top_start.back() );
+
+	if ( num_threads > Num_Rows() )
+		num_threads = Num_Rows();
+	if ( num_threads < 1 )
+		num_threads = 1;
+
+	// thread t takes rows first[t] ... first[t+1]-1
+	vector<int> first ( num_threads + 1, Num_Rows() );
+	first[0] = 0;
+	for ( int r = 0, t = 1; (r < Num_Rows()) && (t < num_threads); r++ )
+		while ( (t < num_threads) && (row_start[r] * num_threads >= Num_Links() * t) )
+			first[t++] = r;
+
+	vector<EdgeBlock> blocks ( num_threads );
+	vector<thread> workers;
+	for ( int t = 0; t < num_threads; t++ )
+	{
+		blocks[t].Clear ( out.Is_Binary() );
+		if ( t > 0 )
+			workers.push_back ( thread ( &TopLinks::Select_Rows, this, first[t], first[t+1],
+										 denoms, &blocks[t] ) );
+	}
+	Select_Rows ( first[0], first[1], denoms, &blocks[0] );
+	for ( unsigned int t = 0; t < workers.size(); t++ )
+		workers[t].join ();
+
+	for ( int t = 0; t < num_threads; t++ )
+		out.Write ( blocks[t] );
+	Clear ( );
+}
+
+// Select_Rows picks the top links of rows first ... last-1 into block.
+// The top links of a row are kept as a heap with the worst of them on
+// top, so a link goes in only if it beats that one.
+
+void TopLinks::Select_Rows ( int first, int last, const vector<float> *denoms, EdgeBlock *block )
+{
+	for ( int r = first; r < last; r++ )
+	{
+		int num_out = num_top[r];
+		if ( num_out == 0 )
+			continue;
+
+		int *row_columns = &columns[row_start[r]];
+		float *row_weights = &weights[row_start[r]];
+		int degree = row_start[r+1] - row_start[r];
+		if ( denoms != NULL )
+			for ( int k = 0; k < degree; k++ )
+				row_weights[k] = row_weights[k] / sqrt ( (*denoms)[rows[r]] * (*denoms)[row_columns[k]] );
+
+		auto better = [row_weights]( int a, int b ) {
+			return ( row_weights[a] > row_weights[b] ) ||
+				   ( row_weights[a] == row_weights[b] && a > b ); };
+
+		int *heap = &top[top_start[r]];
+		for ( int k = 0; k < num_out; k++ )
+			heap[k] = k;
+		make_heap ( heap, heap + num_out, better );
+		for ( int k = num_out; k < degree; k++ )
+			if ( better ( k, heap[0] ) )
+			{
+				pop_heap ( heap, heap + num_out, better );
+				heap[num_out-1] = k;
+				push_heap ( heap, heap + num_out, better );
+			}
+		sort_heap ( heap, heap + num_out, better );
+
+		for ( int k = 0; k < num_out; k++ )
+			block->Write ( rows[r], row_columns[heap[k]], row_weights[heap[k]] );
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef __TOP_LINKS_H__
+#define __TOP_LINKS_H__
+
+// TopLinks picks the top n links of each row of a similarity matrix,
+// as truncate and coarsen write to the .int file.  Rows are added to
+// a batch, then Write shares the rows of the batch out among several
+// threads, each taking a run of rows with about the same number of
+// links: each thread normalizes the links of its rows (optionally),
+// selects their top links and formats them into an EdgeBlock, and the
+// blocks are written in the order the rows were added.
+//
+// The links of a row are kept largest weight first, ties going to the
+// link added later (the larger column, when columns are added in
+// increasing order).  Each row is selected with a min-heap of its n
+// best links so far, O(degree log n) and no allocation per row.
+
+#include <vector>
+
+using namespace std;
+
+#include <EdgeFile.h>
+
+// links held in a batch before it should be written out
+#define TOP_LINKS_BATCH (1L << 20)
+
+class TopLinks {
+
+public:
+
+	// Methods
+	void Clear ( );
+	void Add_Row ( int row, const vector<int> &columns, const vector<float> &weights, int n );
+	void Write ( EdgeWriter &out, int num_threads, const vector<float> *denoms = NULL );
+
+	int Num_Rows ( ) const { return rows.size(); }
+	long Num_Links ( ) const { return columns.size(); }
+
+	// Con/Decon
+	TopLinks ( ) { row_start.push_back ( 0 ); top_start.push_back ( 0 ); }
+	~TopLinks ( ) { }
+
+private:
+
+	void Select_Rows ( int first, int last, const vector<float> *denoms, EdgeBlock *block );
+
+	// the rows of the batch, their links at row_start[r] ... row_start[r+1]-1
+	vector<int> rows, num_top;
+	vector<long> row_start, top_start;
+	vector<int> columns;
+	vector<float> weights;
+
+	// the top links of row r, as offsets into its links, at top_start[r] ...
+	vector<int> top;
+};
+
+#endif // __TOP_LINKS_H__
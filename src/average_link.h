@@ -27,11 +27,4 @@ struct node {
     float y;
 };
 
-// The id_pair structure is used to store indices of an edge pair
-// in the final table (sorted by distance)
-struct id_pair {
-    int row;
-    int col;
-};
-
 #endif
@@ -224,10 +224,10 @@ void average_link::next_line ( int pid1, int pid2, float dist,
 
 }
 
-// This routine outputs the results of the average link clustering
-// algorithm.
+// get_clusters returns the final cluster number of each paper
+// (numbered from 1, with 0 for papers never seen) and its importance.
 
-void average_link::output_clusters ( string filename, map < int, node> &node_info )
+void average_link::get_clusters ( vector<int> &clusters, vector<int> &importances )
 {
 
     // local awk variables
@@ -257,24 +257,16 @@ void average_link::output_clusters ( string filename, map < int, node> &node_inf
     //   for (i=0; i <= 7300; i++) {
     //   for (i=0; i <= 4000000; i++) {
 
-    ofstream clust_out ( filename.c_str() );
-    if ( !clust_out )
-    {
-        cout << "Error: could not open " << filename << ".  Program stopped." << endl;
-        exit(1);
-    }
-    
+    clusters.assign ( max_paper_id+1, 0 );
+    importances = importance;
     for (i=0; i <= max_paper_id; i++) {
         cluster1 = cluster[i];
 	if (cluster1 != 0) {
             while (newcluster[cluster1] != 0) cluster1 = newcluster[cluster1];
 	    if (joinable[cluster1] == 1) nJoinableElements++;
-	    cluster1 = clusternumber[cluster1];  // goes with renumbering scheme
-	    clust_out << node_info[i].id << "\t" << cluster1 << "\t" << importance[i] << endl;
-	    //printf("%d , %d , %d\n", i, cluster1, importance[i]);
+	    clusters[i] = clusternumber[cluster1];  // goes with renumbering scheme
         }
     }
-    clust_out.close();
 
     //  PUT NO COMMAS IN THIS OUTPUT SO EACH LINE IS "ONE" FIELD OF STATS:
     //cout << "nClusters " << nClusters << "   nJoins " << nJoins << "  nJoinable " << nJoinable << endl;
@@ -288,3 +280,100 @@ void average_link::output_clusters ( string filename, map < int, node> &node_inf
     //}
 
 }
+
+// The select_threshold routine automatically selects a distance
+// threshold for use by the average link clustering algorithm.  This
+// threshold is found by going backwards from the largest distance
+// and locating the first incidence of slope = 45 degrees on
+// and normalized rank vs. normalized distance plot.
+// num_neighbors gives the number of neighbors to use when smoothing
+// the curve.
+
+float select_threshold ( vector <float> &min_sim,
+                         int num_neighbors )
+{
+    cout << "Automatically selecting threshold ..." << endl;
+    
+    // first we find the maximum distance and rank
+    // for use in normalization
+    float max_dist;
+
+    int min_sim_i;
+        
+    for ( min_sim_i = 0, max_dist = 0.0; min_sim_i < min_sim.size(); min_sim_i++ )
+          if ( min_sim[min_sim_i] > max_dist )
+               max_dist = min_sim[min_sim_i];
+          
+    int num_dist;
+    num_dist = min_sim.size();
+    
+    // go backwards to first node in the middle of the neighborhood
+    int nhood;
+    min_sim_i = min_sim.size();
+    min_sim_i--;    // last actual distance
+    for ( nhood = 0; (nhood < num_neighbors) && (min_sim_i > 0); nhood++ )
+        min_sim_i--;
+    
+    // go backwards down the normalized curve computing slopes
+    // to select the threshold
+    float uphill, downhill, slope, threshold;
+    bool found_threshold = false;
+    while ( min_sim_i > 0 )
+    {
+        // go uphill to get highest value
+        for ( nhood = 0; (nhood < num_neighbors) && (min_sim_i < min_sim.size()); nhood++ )
+            min_sim_i++;
+            
+        // test to see if we hit the top
+        if ( min_sim_i < min_sim.size() )
+           uphill = min_sim[min_sim_i];
+        else
+        {
+           cout << "Error: automatic threshold identification failed.  Program stopped." << endl;
+           exit(1);
+        }
+        
+        // go downhill to get lowest value
+        for ( nhood = 0; (nhood < 2*num_neighbors) && (min_sim_i > 0); nhood++ )
+            min_sim_i--;
+            
+        // test to see if we hit the bottom
+        if ( min_sim_i > 0 )
+           downhill = min_sim[min_sim_i];
+        else
+        {
+           cout << "Error: automatic threshold identification failed.  Program stopped." << endl;
+           exit(1);
+        }
+        
+        // compute slope using these values
+        slope = ( (float)num_dist/(max_dist*(float)(2*nhood)) )*
+                ( uphill - downhill ); 
+
+        // go back to initial position (this should be safe)
+        for ( nhood =0; nhood < num_neighbors; nhood++ )
+            min_sim_i++;
+        
+        // stop when slope ~ .5
+        if ( slope >= .5 )
+           threshold = min_sim[min_sim_i];
+        else
+        {
+           found_threshold = true;
+           break;
+        }
+           
+        // decrement for next pass
+        min_sim_i--;
+    }
+    
+    if ( !found_threshold )
+    {
+       cout << "Error: automatic threshold identification failed.  Program stopped." << endl;
+       exit(1);
+    }
+    
+    cout << "Found threshold of " << threshold << "." << endl;
+    
+    return threshold;
+}
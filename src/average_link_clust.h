@@ -8,9 +8,6 @@
 #define AVERAGE_LINKH
 
 #include <vector>
-#include <string>
-#include <map>
-#include <average_link.h>
 
 using namespace std;
 
@@ -21,7 +18,7 @@ public:
 	// Methods
 	void next_line ( int pid1, int pid2, float dist,
                      float x1, float y1, float x2, float y2 );
-	void output_clusters ( string filename, map <int, node> &node_info );
+	void get_clusters ( vector<int> &clusters, vector<int> &importances );
 
 	// Con/Decon
 	average_link( int set_max_paper_id, float set_threshold );
@@ -60,4 +57,8 @@ private:
     
 };
 
+// threshold selection for average_link (from the sorted minimum
+// distances of each node)
+float select_threshold ( vector <float> &min_sim, int num_neighbors );
+
 #endif
@@ -0,0 +1,170 @@
+// This file contains the methods of average_link_core.h
+
+// C++ library routines
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+#include <average_link_core.h>
+
+ClusterGraph::ClusterGraph ( const vector<float> &x, const vector<float> &y,
+                             int num_short_links )
+  : min_sim ( x.size(), 0.0 ), x ( x ), y ( y )
+{
+  this->num_short_links = max ( num_short_links, 0 );
+  num_in_row.assign ( x.size(), 0 );
+  short_cols.resize ( (long)x.size() * this->num_short_links );
+  short_dists.resize ( (long)x.size() * this->num_short_links );
+}
+
+// the distance is always taken from the smaller pid, so that an edge
+// gets the same distance whichever way round it is read
+
+float ClusterGraph::Distance ( int pid1, int pid2 ) const
+{
+  if ( pid1 > pid2 )
+    swap ( pid1, pid2 );
+  return sqrt ( pow((x[pid1] - x[pid2]),2) + pow((y[pid1] - y[pid2]),2) );
+}
+
+static bool edge_less ( const cluster_edge &a, const cluster_edge &b )
+{
+  if ( a.dist != b.dist )
+    return a.dist < b.dist;
+  if ( a.row != b.row )
+    return a.row < b.row;
+  return a.col < b.col;
+}
+
+static bool edge_same ( const cluster_edge &a, const cluster_edge &b )
+{
+  return ( a.row == b.row ) && ( a.col == b.col );
+}
+
+void ClusterGraph::Add_Edge ( int pid1, int pid2 )
+{
+  cluster_edge edge;
+  edge.dist = Distance ( pid1, pid2 );
+  edge.row = min ( pid1, pid2 );
+  edge.col = max ( pid1, pid2 );
+  edges.push_back ( edge );
+}
+
+// Sort_Edges sorts the graph and drops repeated edges (which are next
+// to each other, having the same distance), and returns its size
+
+long ClusterGraph::Sort_Edges ( )
+{
+  sort ( edges.begin(), edges.end(), edge_less );
+  edges.erase ( unique ( edges.begin(), edges.end(), edge_same ), edges.end() );
+  return edges.size();
+}
+
+// Add_Short_Link keeps the link pid-col if it is one of the
+// num_short_links shortest of pid.  The slots of a row act as the map
+// average_link used: a link already kept is not added again, but a
+// shorter one still pushes out the longest (the first in column order,
+// for equal lengths).
+
+void ClusterGraph::Add_Short_Link ( int pid, int col, float dist )
+{
+  int *cols = short_cols.data() + (long)pid * num_short_links;
+  float *dists = short_dists.data() + (long)pid * num_short_links;
+  int &num = num_in_row[pid];
+
+  int found = -1, max_k = -1;
+  float max_dist = -1.0;
+  for ( int k = 0; k < num; k++ )
+  {
+    if ( cols[k] == col )
+      found = k;
+    if ( (dists[k] > max_dist) || ((dists[k] == max_dist) && (cols[k] < cols[max_k])) )
+    {
+      max_dist = dists[k];
+      max_k = k;
+    }
+  }
+
+  if ( num < num_short_links )
+  {
+    if ( found < 0 )
+    {
+      cols[num] = col;
+      dists[num++] = dist;
+    }
+  }
+  else if ( dist < max_dist )
+  {
+    if ( found < 0 )
+    {
+      cols[max_k] = col;
+      dists[max_k] = dist;
+    }
+    else
+    {
+      cols[max_k] = cols[--num];
+      dists[max_k] = dists[num];
+    }
+  }
+}
+
+void ClusterGraph::Add_Link ( int pid1, int pid2 )
+{
+  float dist = Distance ( pid1, pid2 );
+
+  // keep track of minimum dist sim for each node
+  if ( (min_sim[pid1] == 0.0) || (min_sim[pid1] > dist) )
+    min_sim[pid1] = dist;
+  if ( (min_sim[pid2] == 0.0) || (min_sim[pid2] > dist) )
+    min_sim[pid2] = dist;
+
+  Add_Short_Link ( pid1, pid2, dist );
+  Add_Short_Link ( pid2, pid1, dist );
+}
+
+// Num_Links counts the links kept (a link kept by both of its nodes
+// counts twice)
+
+long ClusterGraph::Num_Links ( ) const
+{
+  long num_links = 0;
+  for ( unsigned int pid = 0; pid < num_in_row.size(); pid++ )
+    num_links += num_in_row[pid];
+  return num_links;
+}
+
+// Merge_Links adds the links kept to the graph, sorts it and min_sim,
+// and returns the size of the graph
+
+long ClusterGraph::Merge_Links ( )
+{
+  for ( unsigned int pid = 0; pid < num_in_row.size(); pid++ )
+    for ( int k = 0; k < num_in_row[pid]; k++ )
+    {
+      cluster_edge edge;
+      edge.dist = short_dists[(long)pid * num_short_links + k];
+      edge.row = min ( (int)pid, short_cols[(long)pid * num_short_links + k] );
+      edge.col = max ( (int)pid, short_cols[(long)pid * num_short_links + k] );
+      edges.push_back ( edge );
+    }
+  vector<int> ().swap ( num_in_row );
+  vector<int> ().swap ( short_cols );
+  vector<float> ().swap ( short_dists );
+
+  sort ( min_sim.begin(), min_sim.end() );
+  return Sort_Edges ( );
+}
+
+// Cluster passes the graph to the average link clustering, shortest
+// edge first
+
+void ClusterGraph::Cluster ( average_link &cluster )
+{
+  for ( unsigned long i = 0; i < edges.size(); i++ )
+  {
+    int pid1 = edges[i].row, pid2 = edges[i].col;
+    cluster.next_line ( pid1, pid2, edges[i].dist, x[pid1], y[pid1], x[pid2], y[pid2] );
+  }
+}
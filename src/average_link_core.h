@@ -0,0 +1,65 @@
+// This file contains the core of average_link, shared by the
+// average_link program and openord_multilevel: the edges left by layout
+// and the shortest .full links of each node are gathered into one
+// graph, sorted by distance for the average link clustering.
+
+#ifndef AVERAGE_LINK_COREH
+#define AVERAGE_LINK_COREH
+
+#include <vector>
+
+using namespace std;
+
+#include <average_link_clust.h>
+
+// an edge of the graph, between nodes (pids) row <= col
+struct cluster_edge {
+  float dist;
+  int row;
+  int col;
+};
+
+// The ClusterGraph class gathers the graph of a layout, in the pids of
+// its nodes (the numbers given to the ids in sorted order, which decide
+// the order that equal distances are clustered in).  Add_Edge adds an
+// edge left by layout, Add_Link a .full link, of which the
+// num_short_links shortest of each node are kept, and Merge_Links puts
+// the kept links into the graph.  Repeated edges count once, and the
+// graph is sorted by distance, then row, then column.
+
+class ClusterGraph {
+
+public:
+
+	// Methods
+	void Add_Edge ( int pid1, int pid2 );
+	long Sort_Edges ( );
+	void Add_Link ( int pid1, int pid2 );
+	long Num_Links ( ) const;
+	long Merge_Links ( );
+	void Cluster ( average_link &cluster );
+
+	vector<cluster_edge> edges;		// the graph (sorted by Sort_Edges and Merge_Links)
+	vector<float> min_sim;			// shortest .full link of each node, 0 if none
+									// (sorted by Merge_Links, for select_threshold)
+
+	// Con/Decon
+	ClusterGraph ( const vector<float> &x, const vector<float> &y, int num_short_links );
+	~ClusterGraph ( ) { }
+
+private:
+
+	float Distance ( int pid1, int pid2 ) const;
+	void Add_Short_Link ( int pid, int col, float dist );
+
+	vector<float> x, y;				// coordinates of each pid
+
+	// the shortest links of node pid are in its num_short_links slots,
+	// from pid*num_short_links, of which num_in_row[pid] are used
+	int num_short_links;
+	vector<int> num_in_row;
+	vector<int> short_cols;
+	vector<float> short_dists;
+};
+
+#endif
@@ -0,0 +1,254 @@
+// This file contains the functions of coarsen_core.h
+
+// C++ library routines
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <math.h>
+#include <cstdlib>
+
+using namespace std;
+
+#include <coarsen_core.h>
+#include <TopLinks.h>
+
+void check_clusters ( vector <int> &cluster_sizes, int num_clusts,
+                      int &min_clust, int &max_clust )
+{
+  if ( num_clusts < 1 )
+  {
+    cout << "Error: no clusters found." << endl;
+    exit(1);
+  }
+  
+  // check that cluster ids go from 0 to #clusters-1 with no gaps (for layout)
+  for ( int i = 0; i < num_clusts; i ++ )
+    if ( cluster_sizes[i] == 0 )
+    {
+        cout << "Error: cluster ids are not sequential at " << i <<"." << endl;
+        exit(1);
+    }
+  
+  // compute max and min cluster sizes
+  min_clust = max_clust = cluster_sizes[0];
+  for ( int i = 0; i < num_clusts; i++ )
+  {
+    if ( min_clust > cluster_sizes[i] ) min_clust = cluster_sizes[i];
+    if ( max_clust < cluster_sizes[i] ) max_clust = cluster_sizes[i];
+  }
+  
+  cout << "Maximum cluster size " << max_clust << ", minimum cluster size "
+       << min_clust << "." << endl;
+}
+
+// read_rows reads the rows of the .full file for the nodes in_block
+// accepts: each edge goes in the rows of both its ends, a repeated
+// edge replaces the earlier one, and each row is sorted by column.
+// The entries of row j are row[offset[j]] to row[offset[j+1]-1], as
+// (j, column, weight) records.  Nodes past the end of the .clust file
+// are added to cluster_membership, in cluster 0.
+
+static bool column_less ( const EdgeRecord &a, const EdgeRecord &b )
+{
+  return a.id2 < b.id2;
+}
+
+static void read_rows ( EdgeFile &in, const function<bool ( int )> &in_block,
+                        vector <int> &cluster_membership,
+                        vector <long> &offset, vector <EdgeRecord> &row )
+{
+  // the records of the block, in file order
+  vector <EdgeRecord> records;
+  EdgeRecord forward, backward;
+  in.Rewind ();
+  while ( in.Next ( forward.id1, forward.id2, forward.weight ) )
+  {
+    if ( (forward.id1 < 0) || (forward.id2 < 0) )
+    {
+      cout << "Error: negative id in .full file.  Program terminated." << endl;
+      exit(1);
+    }
+    int top = max ( forward.id1, forward.id2 );
+    if ( top >= (int)cluster_membership.size() )
+      cluster_membership.resize ( top+1, 0 );
+    
+    backward.id1 = forward.id2;
+    backward.id2 = forward.id1;
+    backward.weight = forward.weight;
+    if ( in_block ( forward.id1 ) )
+      records.push_back ( forward );
+    if ( in_block ( backward.id1 ) )
+      records.push_back ( backward );
+  }
+  
+  // counting sort by row (stable, so repeats stay in file order)
+  int num_rows = cluster_membership.size();
+  vector <long> start ( num_rows+1, 0 );
+  for ( unsigned long i = 0; i < records.size(); i++ )
+    start[records[i].id1+1]++;
+  for ( int j = 0; j < num_rows; j++ )
+    start[j+1] += start[j];
+  row.resize ( records.size() );
+  vector <long> next ( start.begin(), start.end()-1 );
+  for ( unsigned long i = 0; i < records.size(); i++ )
+    row[next[records[i].id1]++] = records[i];
+  records.clear ();
+  records.shrink_to_fit ();
+  
+  // sort each row by column and keep the last entry for each column
+  offset.assign ( num_rows+1, 0 );
+  long kept = 0;
+  for ( int j = 0; j < num_rows; j++ )
+  {
+    stable_sort ( row.begin()+start[j], row.begin()+start[j+1], column_less );
+    for ( long k = start[j]; k < start[j+1]; k++ )
+      if ( (k+1 == start[j+1]) || (row[k+1].id2 != row[k].id2) )
+        row[kept++] = row[k];
+    offset[j+1] = kept;
+  }
+  row.resize ( kept );
+}
+
+// This routine scans the .full file to get the normalization denominators
+void get_denoms ( EdgeFile &in, int memory_use, int num_nodes, int num_clusts,
+                 vector <int> &cluster_membership, vector <float> &denom_sims )
+{
+  cout << "Computing normalization denominators ..." << endl;
+  
+  // initialize denominators to zero
+  int i;
+  for ( i = 0; i < num_clusts; i++ )
+    denom_sims[i] = 0.0;
+    
+  // run multiple scans of .full file and record denominators
+  int mem_step = num_nodes/memory_use;
+  vector <long> offset;
+  vector <EdgeRecord> row;
+  int j;
+
+  for ( i = 0; i < memory_use; i++ )
+  {
+      int mem_start = mem_step*i;
+      int mem_stop = mem_step*(i+1);
+      if ( i+1 == memory_use )
+        mem_stop = num_nodes;
+
+      // scan in the similarities for a block of nodes
+      cout << "Scan " << i+1 << " of .full file ..." << endl;     
+      read_rows ( in, [&]( int id ) { return (mem_start <= id) && (id < mem_stop); },
+                  cluster_membership, offset, row );
+
+      // compute denominator sums
+      for ( j = mem_start; j < mem_stop; j++ )
+        for ( long k = offset[j]; k < offset[j+1]; k++ )
+          denom_sims[cluster_membership[j]] = denom_sims[cluster_membership[j]] + row[k].weight;
+  }
+}
+
+// Now we do the actual coarsening.  The nodes of each cluster are
+// listed in increasing order, and the similarities of a cluster are
+// summed over the rows of its nodes into a dense array indexed by
+// cluster, so each sum is taken in the same order as before.
+void coarsen_full ( EdgeFile &in, EdgeWriter &out_full, EdgeWriter &out_int,
+                    int memory_use, int num_clusts, vector <int> &cluster_sizes,
+                    int min_clust, int max_clust, int *topn_links,
+                    vector <int> &cluster_membership, vector <float> &denom_sims,
+                    int num_threads )
+{
+  cout << "Coarsening graph ..." << endl;
+  
+  // run multiple scans of .full file
+  int mem_step = num_clusts/memory_use;
+  vector <long> offset;
+  vector <EdgeRecord> row;
+  vector <long> member_start;
+  vector <int> members;
+  vector <float> coarse_sim ( num_clusts, 0.0 );
+  vector <bool> coarse_used ( num_clusts, false );
+  vector <int> coarse_cols;
+  vector <int> row_columns;
+  vector <float> row_weights;
+  TopLinks top_links;
+  int i, j, k;
+  int topn;
+  for ( i = 0; i < memory_use; i++ )
+  {
+      int mem_start = mem_step*i;
+      int mem_stop = mem_step*(i+1);
+      if ( i+1 == memory_use )
+        mem_stop = num_clusts;
+
+      // scan in the similarities for a block of nodes
+      cout << "Scan " << i+1 << " of .full file ..." << endl;     
+      read_rows ( in, [&]( int id ) { return (mem_start <= cluster_membership[id]) &&
+                                             (cluster_membership[id] < mem_stop); },
+                  cluster_membership, offset, row );
+      
+      // the nodes of each cluster, in increasing order
+      int num_nodes = cluster_membership.size();
+      member_start.assign ( num_clusts+1, 0 );
+      for ( j = 0; j < num_nodes; j++ )
+        member_start[cluster_membership[j]+1]++;
+      for ( k = 0; k < num_clusts; k++ )
+        member_start[k+1] += member_start[k];
+      members.resize ( num_nodes );
+      vector <long> next ( member_start.begin(), member_start.end()-1 );
+      for ( j = 0; j < num_nodes; j++ )
+        members[next[cluster_membership[j]]++] = j;
+
+      cout << "Computing similarities ..." << endl;
+      for ( j = mem_start; j < mem_stop; j++ )
+      {
+        // compute cluster similarities
+        coarse_cols.clear();
+        for ( long m = member_start[j]; m < member_start[j+1]; m++ )
+          for ( long e = offset[members[m]]; e < offset[members[m]+1]; e++ )
+          {
+            k = cluster_membership[row[e].id2];
+            if ( !coarse_used[k] )
+            {
+              coarse_used[k] = true;
+              coarse_cols.push_back ( k );
+              coarse_sim[k] = 0.0;
+            }
+            coarse_sim[k] = coarse_sim[k] + row[e].weight;
+          }
+        if ( coarse_cols.empty() )
+          continue;
+        sort ( coarse_cols.begin(), coarse_cols.end() );
+        
+        // write out to .full file & normalize similarities
+        row_columns.clear();
+        row_weights.clear();
+        for ( unsigned int c = 0; c < coarse_cols.size(); c++ )
+        {
+          k = coarse_cols[c];
+          coarse_used[k] = false;
+		  // output self links only if there are no other links
+          if ( (j != k) ) // || (coarse_cols.size() == 1) )
+          {
+            out_full.Write ( j, k, coarse_sim[k] );
+            // normalize for .int output
+            row_columns.push_back ( k );
+            row_weights.push_back ( coarse_sim[k]/sqrt(denom_sims[j]*denom_sims[k]) );
+          }
+        }
+        
+        // top n for this cluster
+        if ( min_clust == max_clust )        // if all clusters are the same use min links
+          topn = topn_links[0];
+        else                                 // variable number of clusters
+          topn = (int)((float)topn_links[0] + (float)(topn_links[1]-topn_links[0]) * 
+                ((log((float)cluster_sizes[j]) - log((float)min_clust))/
+				(log((float)max_clust)-log((float)min_clust))));
+        top_links.Add_Row ( j, row_columns, row_weights, topn );
+        
+        // select and output a batch of rows, largest first
+        // (ties go to the larger cluster)
+        if ( top_links.Num_Links() >= TOP_LINKS_BATCH )
+          top_links.Write ( out_int, num_threads );
+      }
+      top_links.Write ( out_int, num_threads );
+  }
+}
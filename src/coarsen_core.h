@@ -0,0 +1,30 @@
+// This file contains the core of coarsen, shared by the coarsen
+// program and openord_multilevel: the nodes of a .full graph are
+// merged by cluster into the coarse .full graph, and the top links of
+// each cluster give the coarse .int graph.
+
+#ifndef COARSEN_COREH
+#define COARSEN_COREH
+
+#include <vector>
+
+using namespace std;
+
+#include <EdgeFile.h>
+
+// check_clusters checks that every cluster from 0 to num_clusts-1 has
+// nodes (for layout) and finds the smallest and largest clusters
+void check_clusters ( vector <int> &cluster_sizes, int num_clusts,
+                      int &min_clust, int &max_clust );
+
+// get_denoms and coarsen_full scan the .full graph memory_use times,
+// each time for 1/memory_use of the nodes (or clusters)
+void get_denoms ( EdgeFile &in, int memory_use, int num_nodes, int num_clusts,
+                  vector <int> &cluster_membership, vector <float> &denom_sims );
+void coarsen_full ( EdgeFile &in, EdgeWriter &out_full, EdgeWriter &out_int,
+                    int memory_use, int num_clusts, vector <int> &cluster_sizes,
+                    int min_clust, int max_clust, int *topn_links,
+                    vector <int> &cluster_membership, vector <float> &denom_sims,
+                    int num_threads );
+
+#endif
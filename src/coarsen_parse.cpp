@@ -54,7 +54,9 @@ void parse::print_syntax( const char *error_string )
        << "\t                     top n links." << endl
        << "\t-m {int>=1} scans the file m times for memory conservation" << endl
        << "\t            (default 1)" << endl 
-       << "\t-n produces normalized similarities in .int" << endl << endl;
+       << "\t-n produces normalized similarities in .int" << endl
+       << "\t-b writes binary .full and .int files (see convert_edges)" << endl
+       << "\t-p {int>=1} threads selecting the top links (default 1)" << endl << endl;
            
     exit(1);
 }
@@ -76,6 +78,8 @@ parse::parse ( int argc, char** argv)
   top_n_links[1] = 15;
   normalized_output = false;
   memory_use = 1;
+  binary = false;
+  num_threads = 1;
   
   // now check for optional arguments
   string arg;
@@ -129,9 +133,25 @@ parse::parse ( int argc, char** argv)
 		}
 	}
 	
+	// check for threads
+	else if ( arg == "-p" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-p flag has no argument." );
+		else
+		{
+			num_threads = atoi ( argv[i] );
+			if ( num_threads < 1 )
+				print_syntax ( "number of threads must be >= 1." );
+		}
+	}
+	
     // check for normalized output
     else if ( arg == "-n" )
 	    normalized_output = true;
+    else if ( arg == "-b" )
+	    binary = true;
     else
         print_syntax ( "unrecongized option!" );
   }
@@ -165,6 +185,8 @@ parse::parse ( int argc, char** argv)
        << "      scan file times = " << memory_use << endl
        << "      number of sim links to output = " << top_n_links[0]
        << " to " << top_n_links[1] << endl
-       << "      normalized output = " << normalized_output << endl;
+       << "      normalized output = " << normalized_output << endl
+       << "      binary output = " << binary << endl
+       << "      threads = " << num_threads << endl;
 
 }
@@ -25,6 +25,8 @@ public:
 	int top_n_links[2];	    // number of shortest links to add > 0
 	bool normalized_output; // true to produce normalized output
 	int memory_use;         // number of times to scan file 
+	bool binary;            // true to write binary .full and .int
+	int num_threads;        // threads selecting top links, int >= 1
     
 private:
 
@@ -0,0 +1,73 @@
+// Convert_edges.cpp --
+//
+// This program converts .int and .full files between the text format
+// (id <tab> id <tab> weight) and the binary format read by the other
+// tools with mmap (see EdgeFile.h).
+//
+// The structure of the inputs and outputs of this code will be displayed
+// if the program is called without parameters, or if an erroneous
+// parameter is passed to the program.
+
+// C++ library routines
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+
+// parse command line
+#include <convert_edges_parse.h>
+#include <EdgeFile.h>
+
+int main(int argc, char *argv[]) {
+ 
+  // get user input
+  parse command_line ( argc, argv );
+  
+  EdgeFile in;
+  if ( !in.Open ( command_line.in_file.c_str() ) )
+  {
+    cout << "Error: could not open " << command_line.in_file
+	     << " (or it is a damaged binary file).  Program terminated." << endl;
+	exit (1);
+  }
+  
+  bool binary_out = !in.Is_Binary();
+  if ( binary_out )
+    cout << "Converting text to binary ..." << endl;
+  else
+    cout << "Converting binary to text ..." << endl;
+  
+  EdgeWriter out;
+  if ( !out.Open ( command_line.out_file.c_str(), binary_out, command_line.sorted ) )
+  {
+    cout << "Error: could not open " << command_line.out_file << ".  Program terminated." << endl;
+	exit (1);
+  }
+  
+  int id1, id2;
+  float weight;
+  long num_edges = 0;
+  while ( in.Next ( id1, id2, weight ) )
+  {
+    if ( (id1 < 0) || (id2 < 0) )
+	{
+	  cout << "Error: found negative id in " << command_line.in_file << ".  Program terminated." << endl;
+	  exit (1);
+	}
+    out.Write ( id1, id2, weight );
+	num_edges++;
+  }
+  
+  in.Close ();
+  if ( !out.Close () )
+  {
+    cout << "Error: could not write " << command_line.out_file << ".  Program terminated." << endl;
+	exit (1);
+  }
+  
+  cout << "Converted " << num_edges << " edges." << endl;
+  cout << "Program finished successfully." << endl;
+}
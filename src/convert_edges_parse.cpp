@@ -0,0 +1,68 @@
+// This file contains the methods for the parse.h class
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+#include <convert_edges_parse.h>
+
+void parse::print_syntax( const char *error_string )
+{
+  cout << endl << "Error: " << error_string << endl;
+  cout << endl << "Convert Edges" << endl
+	   <<         "-------------" << endl
+	   << "Version " << VERSION << endl << endl
+	   << "Converts .int and .full files between the text and binary formats." << endl << endl
+	   << "Usage: convert_edges [options] in_file out_file" << endl << endl
+	   << "in_file -- the edge file to convert (the format is detected)." << endl
+	   << "out_file -- the converted file." << endl << endl
+	   << "FORMATS" << endl
+	   << "-------" << endl 
+	   << "A text edge file has the format" << endl
+	   << "\tint_id <tab> int_id <tab> weight" << endl
+	   << "where int_id's are integers >= 0 and weight is a float." << endl << endl
+	   << "A binary edge file has a 32 byte header followed by one 12 byte" << endl
+	   << "record (int32 id, int32 id, float32 weight) per edge, and is read" << endl
+	   << "by layout, coarsen, refine and average_link without parsing.  Text" << endl
+	   << "input is written as binary and binary input is written as text." << endl << endl
+	   << "OPTIONS" << endl
+	   << "-------" << endl
+       << "\t-s : sort binary output by node and add a row offset table." << endl << endl;    
+    exit(1);
+}
+
+parse::parse ( int argc, char** argv)
+{
+
+  // make sure there are at least two file arguments 
+  if ( argc < 3)
+	print_syntax ( "not enough arguments!" );
+  
+  in_file = argv[argc-2];
+  out_file = argv[argc-1];
+  
+  // set defaults
+  sorted = false;
+  
+  // now check for optional arguments
+  string arg;
+  for( int i = 1; i<argc-2; i++ )
+  {
+	arg = argv[i];
+	
+	// check for sorted output
+	if ( arg == "-s" )
+	    sorted = true;
+    else
+        print_syntax ( "unrecongized option!" );
+  }
+  
+  if ( in_file == out_file )
+    print_syntax ( "input and output files must be different." );
+  
+  cout << "Using " << in_file << " for input, " << endl
+	   << "Will output " << out_file << "." << endl;
+		 
+}
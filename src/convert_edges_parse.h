@@ -0,0 +1,30 @@
+// The parse class contains the methods necessary to parse
+// the command line, print help, and do error checking
+
+#ifndef PARSEH
+#define PARSEH
+
+#define VERSION "1.0 10/17/2026"
+
+class parse {
+
+public:
+
+    // Methods
+	
+	parse ( int argc, char **argv );
+	~parse () {}
+	
+	// user parameters
+	string in_file;			// edge file (input, text or binary)
+	string out_file;		// edge file (output, the other format)
+	
+	bool sorted;			// true to sort binary output by node
+	
+private:
+
+	void print_syntax ( const char *error_string );
+
+};
+
+#endif
@@ -7,10 +7,14 @@
 #include <math.h>
 #include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
 
 using namespace std;
 
 #include <graph.h>
+#include <Checkpoint.h>
 #ifdef MUSE_MPI
   #include <mpi.h>
 #endif
@@ -18,12 +22,65 @@ using namespace std;
 // constructor -- initializes the schedule variables (as in 
 // graph constructor)
 
-graph::graph ( int proc_id, int tot_procs, char *int_file )
+graph::graph ( int proc_id, int tot_procs, const char *int_file )
+{
+		  init_schedule ( proc_id, tot_procs );
+
+		  // read .int file for graph info
+		  read_int ( int_file );
+		  init_positions ( );
+}
+
+// constructor for a graph which is already in memory (edges are as
+// they would be read from an .int file)
+
+graph::graph ( int proc_id, int tot_procs, const vector<EdgeRecord> &edges )
+{
+		  init_schedule ( proc_id, tot_procs );
+		  read_edges ( edges );
+		  init_positions ( );
+}
+
+// constructor for an incremental layout (layout -u): the graph is
+// the cut graph of a previous layout (its .iedges file) changed by the
+// edges in delta_file, and nodes start at their coordinates in the
+// previous layout (its .icoord file).  init_update must be called once
+// the layout is set up.
+
+graph::graph ( int proc_id, int tot_procs, const char *coord_file, const char *edges_file,
+			   const char *delta_file )
+{
+		  init_schedule ( proc_id, tot_procs );
+		  read_update ( coord_file, edges_file, delta_file );
+}
+
+// constructor for a copy of a graph which has been read but not yet
+// laid out, so a graph read once can be laid out several times
+// (layout_trials).  Only the graph is copied: the schedule and engine
+// start over, as for a graph just read.
+
+graph::graph ( const graph &loaded )
+{
+		  init_schedule ( loaded.myid, loaded.num_procs );
+		  num_nodes = loaded.num_nodes;
+		  highest_sim = loaded.highest_sim;
+		  id_catalog = loaded.id_catalog;
+		  neighbors = loaded.neighbors;
+		  positions = loaded.positions;
+}
+
+// init_schedule sets the MPI information and the default schedule
+
+void graph::init_schedule ( int proc_id, int tot_procs )
 {
 		  
 		  // MPI parameters
 		  myid = proc_id;
 		  num_procs = tot_procs;
+		  quiet = false;
+		  num_threads = 1;
+		  block_size = 1;
+		  density_server = NULL;
 
 		  // initial annealing parameters
 		  STAGE = 0;
@@ -41,41 +98,55 @@ graph::graph ( int proc_id, int tot_procs, char *int_file )
 		  liquid.attraction = 2;
 		  liquid.damping_mult = 1.0;
 		  liquid.time_elapsed = 0;
+		  liquid.min_iterations = -1;
 
 		  expansion.iterations = 200;
 		  expansion.temperature = 2000;
 		  expansion.attraction = 10;
 		  expansion.damping_mult = 1.0;
 		  expansion.time_elapsed = 0;
+		  expansion.min_iterations = -1;
 
 		  cooldown.iterations = 200;
 		  cooldown.temperature = 2000;
 		  cooldown.attraction = 1;
 		  cooldown.damping_mult = .1;
 		  cooldown.time_elapsed = 0;
+		  cooldown.min_iterations = -1;
 
 		  crunch.iterations = 50;
 		  crunch.temperature = 250;
 		  crunch.attraction = 1;
 		  crunch. damping_mult = .25;
 		  crunch.time_elapsed = 0;
+		  crunch.min_iterations = -1;
 
 		  simmer.iterations = 100;
 		  simmer.temperature = 250;
 		  simmer.attraction = .5;
 		  simmer.damping_mult = 0.0;
 		  simmer.time_elapsed = 0;
-
-		  // scan .int file for node info
-		  scan_int ( int_file );
+		  simmer.min_iterations = -1;
+		  
+		  // adaptive schedule is off
+		  adapt_tol = 0;
+		  iterations_saved = 0;
 		  
+		  // every node is moved every iteration
+		  active_threshold = 0;
+		  active_skipped = active_updates = 0;
+}
+
+// init_positions populates node positions and ids once the graph
+// has been read
+
+void graph::init_positions ( )
+{
 		  // populate node positions and ids
 		  positions.reserve ( num_nodes );
-		  map < int, int >::iterator cat_iter;
-		  for ( cat_iter = id_catalog.begin();
-			    cat_iter != id_catalog.end();
-				cat_iter++ )
-			positions.push_back ( Node( cat_iter->first ) );
+		  for ( int file_id = 0; file_id < (int)id_catalog.size(); file_id++ )
+			if ( id_catalog[file_id] >= 0 )
+			  positions.push_back ( Node( file_id ) );
 		  
 		  /*
 		  // output positions .ids for debugging
@@ -83,95 +154,11 @@ graph::graph ( int proc_id, int tot_procs, char *int_file )
 			cout << positions[id].id << endl;
 		  */
 		  
-		  // read .int file for graph info
-		  read_int ( int_file );
-		  
-		  // initialize density server
-		  density_server.Init();
-		  
-}
-
-// The following subroutine scans the .int file for the following
-// information: number nodes, node ids, and highest similarity.  The
-// corresponding graph globals are populated: num_nodes, id_catalog,
-// and highest_sim.
-
-void graph::scan_int ( char *filename )
-{
-
-  cout << "Proc. " << myid << " scanning .int file ..." << endl;
-  
-  // Open (sim) File
-  ifstream fp ( filename );
-  if ( !fp )
-  {
-	cout << "Error: could not open " << filename << ".  Program terminated." << endl;
-	#ifdef MUSE_MPI
-	  MPI_Abort ( MPI_COMM_WORLD, 1 );
-	#else
-	  exit (1);
-    #endif
-  }	
-  
-  // Read file, parse, and add into data structure
-  int id1, id2;
-  float edge_weight;
-  highest_sim = -1.0;
-  while ( !fp.eof () )
-	{
-	  fp >> id1 >> id2 >> edge_weight;
-	  
-	  // ignore negative weights!
-	  if ( edge_weight <= 0 )
-	  {
-	     cout << "Error: found negative edge weight in " << filename << ".  Program stopped." << endl;
-		 #ifdef MUSE_MPI
-	       MPI_Abort ( MPI_COMM_WORLD, 1 );
-	     #else
-	       exit (1);
-         #endif
-	   }
-
-	   if ( highest_sim < edge_weight )
-	      highest_sim = edge_weight;
-	
-	   id_catalog[id1] = 1;
-	   id_catalog[id2] = 1;
-	}
-
-  fp.close();
-
-  if ( id_catalog.size() == 0 )
-  {
-    cout << "Error: Proc. " << myid << ": " << filename << " is empty.  Program terminated." << endl;
-	#ifdef MUSE_MPI
-	  MPI_Abort ( MPI_COMM_WORLD, 1 );
-	#else
-	  exit (1);
-	#endif
-  }
-  
-  // label nodes with sequential integers starting at 0
-  map< int, int>::iterator cat_iter;
-  int id_label;
-  for ( cat_iter = id_catalog.begin(), id_label = 0;
-	    cat_iter != id_catalog.end(); cat_iter++, id_label++ )
-    cat_iter->second = id_label;
-
-  /*
-  // output id_catalog for debugging:
-  for ( cat_iter = id_catalog.begin();
-		cat_iter != id_catalog.end();
-		cat_iter++ )
-	cout << cat_iter->first << "\t" << cat_iter->second << endl;
-  */
-  
-  num_nodes = id_catalog.size();  
 }
 
 // read in .parms file, if present
 
-void graph::read_parms ( char *parms_file )
+void graph::read_parms ( const char *parms_file )
 {
 
 		  // read from .parms file
@@ -227,10 +214,29 @@ void graph::read_parms ( char *parms_file )
 		  parms_in >> parm_label >> simmer.attraction;
 		  parms_in >> parm_label >> simmer.damping_mult;
 		  
+		  // optional fewest iterations for the adaptive schedule, one
+		  // "stage.min_iterations value" line per stage
+		  int min_iterations;
+		  while ( parms_in >> parm_label >> min_iterations )
+		  {
+		    if ( parm_label == "liquid.min_iterations" )
+			  liquid.min_iterations = min_iterations;
+		    else if ( parm_label == "expansion.min_iterations" )
+			  expansion.min_iterations = min_iterations;
+		    else if ( parm_label == "cooldown.min_iterations" )
+			  cooldown.min_iterations = min_iterations;
+		    else if ( parm_label == "crunch.min_iterations" )
+			  crunch.min_iterations = min_iterations;
+		    else if ( parm_label == "simmer.min_iterations" )
+			  simmer.min_iterations = min_iterations;
+		    else if ( myid == 0 )
+			  cout << "Warning: ignoring " << parm_label << " in .parms file." << endl;
+		  }
+		  
 		  parms_in.close();
 
 		  // print out parameters for double checking
-		  if ( myid == 0 )
+		  if ( talk () )
 		  {
 		    cout << "Processor 0 reports the following inputs:" << endl;
 			cout << "inital.iterations = " << iterations << endl;
@@ -301,21 +307,310 @@ void graph::init_parms ( int rand_seed, float edge_cut, float real_parm )
 	*/
 	
 	// set random seed
-	srand ( rand_seed );
+	rng = CounterRng ( rand_seed );
+	
+}
+
+// init_engine -- chooses how the node sweep is divided up.  block is
+// the number of nodes each MPI proc moves between position exchanges
+// (1 reproduces the original one-node-per-proc schedule).  threads > 1
+// selects the shared memory engine.  Random jumps depend only on the
+// seed, iteration and node, so every engine proposes the same jumps.
+
+void graph::init_engine ( int threads, int block )
+{
+	num_threads = threads;
+	block_size = block;
+	
+	batch_pos.resize ( 2*num_threads*THREAD_BATCH );
+	batch_sub.resize ( 2*num_threads*THREAD_BATCH );
+	batch_moved.resize ( num_threads*THREAD_BATCH );
+	
+	if ( num_threads > 1 && !quiet )
+	  cout << "Processor " << myid << " using " << num_threads << " threads." << endl;
+}
+
+// init_grid -- initializes the density server.  grid_size is the
+// number of density grid cells along each side, or 0 to size the
+// grid from the number of nodes.  If theta > 0 repulsion comes from
+// a Barnes-Hut tree with opening angle theta instead of the density
+// grid (the grid size then just sets the layout plane).  Must be
+// called before read_real.
+
+void graph::init_grid ( int grid_size, float theta )
+{
+	delete density_server;
+	if ( theta > 0 )
+	  density_server = new DensityTree ( theta );
+	else
+	  density_server = new DensityGrid;
+	density_server->Init ( num_nodes, grid_size );
+	
+	if ( talk () )
+	{
+	  if ( theta > 0 )
+		cout << "Using Barnes-Hut density tree, theta = " << theta << " (layout plane "
+			 << density_server->View_Size() << " across)." << endl;
+	  else
+		cout << "Using " << density_server->Grid_Size() << " x "
+			 << density_server->Grid_Size() << " density grid (layout plane "
+			 << density_server->View_Size() << " across)." << endl;
+	}
+}
+
+// init_profile -- turns on profiling (layout -m).  After each
+// iteration a line of timings and counts is written to profile_file
+// by proc. 0, summed over threads and procs.  Must be called after
+// init_engine.
+
+void graph::init_profile ( const char *profile_file )
+{
+	profile.assign ( num_threads, LayoutProfile () );
+	
+	if ( myid == 0 )
+	{
+	  profile_out.open ( profile_file );
+	  if ( !profile_out )
+	  {
+		cout << "Error: could not open " << profile_file << ".  Program stopped." << endl;
+		#ifdef MUSE_MPI
+		  MPI_Abort ( MPI_COMM_WORLD, 1 );
+		#else
+		  exit (1);
+		#endif
+	  }
+	  profile_out << "iteration,stage,seconds,";
+	  LayoutProfile::Write_Header ( profile_out );
+	  profile_out << ",imbalance" << endl;
+	}
+}
+
+// init_adaptive -- turns on the adaptive schedule (layout -a).  The
+// total energy and the mean distance moved by a node are kept for the
+// last 2*ADAPT_WINDOW iterations of a stage.  The stage has converged
+// when the average of each over the last ADAPT_WINDOW iterations
+// differs from the average over the ADAPT_WINDOW before by at most
+// tolerance (relative) per iteration.  (Averages are compared as
+// both quantities jitter with the random jumps.)  A stage then ends
+// once it has converged and run its min_iterations, or after its
+// iterations as usual.
+
+void graph::init_adaptive ( float tolerance )
+{
+	adapt_tol = tolerance;
+	adapt_x.resize ( num_nodes );
+	adapt_y.resize ( num_nodes );
+	for ( int i = 0; i < num_nodes; i++ )
+	{
+	  adapt_x[i] = positions[i].x;
+	  adapt_y[i] = positions[i].y;
+	}
 	
+	if ( talk () )
+	  cout << "Using adaptive schedule, tolerance = " << adapt_tol << "." << endl;
+}
+
+// track_convergence is called after each iteration of an adaptive
+// schedule.  Positions are the same on every proc., but each proc.
+// has the energies of the nodes it moved, so the energy is summed
+// over the procs. (every proc. must end the stage together).
+
+void graph::track_convergence ( )
+{
+	double energy = 0, displacement = 0;
+	for ( int i = myid; i < num_nodes; i += num_procs )
+	  energy += positions[i].energy;
+	#ifdef MUSE_MPI
+	  double my_energy = energy;
+	  MPI_Allreduce ( &my_energy, &energy, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD );
+	#endif
+	
+	int num_moving = 0;
+	for ( int i = 0; i < num_nodes; i++ )
+	{
+	  if ( positions[i].fixed && real_fixed )
+		continue;
+	  float x_dis = positions[i].x - adapt_x[i];
+	  float y_dis = positions[i].y - adapt_y[i];
+	  displacement += sqrt ( x_dis*x_dis + y_dis*y_dis );
+	  adapt_x[i] = positions[i].x;
+	  adapt_y[i] = positions[i].y;
+	  num_moving++;
+	}
+	if ( num_moving > 0 )
+	  displacement /= num_moving;
+	
+	adapt_energy.push_back ( energy );
+	adapt_displacement.push_back ( displacement );
+	if ( (int)adapt_energy.size() > 2*ADAPT_WINDOW )
+	{
+	  adapt_energy.erase ( adapt_energy.begin() );
+	  adapt_displacement.erase ( adapt_displacement.begin() );
+	}
+}
+
+// steady is true if the last ADAPT_WINDOW values of history average
+// within tolerance per iteration of the ADAPT_WINDOW before
+
+static bool steady ( const vector<double> &history, float tolerance )
+{
+	if ( (int)history.size() < 2*ADAPT_WINDOW )
+	  return false;
+	double before = 0, after = 0;
+	for ( int i = 0; i < ADAPT_WINDOW; i++ )
+	{
+	  before += history[i];
+	  after += history[ADAPT_WINDOW+i];
+	}
+	return fabs ( after - before ) <= tolerance*ADAPT_WINDOW*fabs ( before );
+}
+
+// stage_done is true when the current stage has run its iterations
+// or, with an adaptive schedule, has converged
+
+bool graph::stage_done ( const layout_schedule &stage )
+{
+	bool done = iterations >= stage.iterations;
+	if ( !done && adapt_tol > 0 )
+	{
+	  int min_iterations = stage.min_iterations;
+	  if ( min_iterations < 0 )
+		min_iterations = (int)( ADAPT_MIN_FRACTION*stage.iterations );
+	  if ( iterations >= min_iterations && steady ( adapt_energy, adapt_tol ) &&
+		   steady ( adapt_displacement, adapt_tol ) )
+	  {
+		done = true;
+		iterations_saved += stage.iterations - iterations;
+		if ( talk () )
+		  cout << endl << "Converged after " << iterations << " of " << stage.iterations
+			   << " iterations.";
+	  }
+	}
+	
+	// (the next stage starts a new history)
+	if ( done )
+	{
+	  adapt_energy.clear ();
+	  adapt_displacement.clear ();
+	}
+	return done;
+}
+
+// init_active -- turns on the active set (layout -x).  From stage
+// ACTIVE_FIRST_STAGE on, a node is skipped if neither it nor any of
+// its neighbors moved threshold or more in the last iteration, but
+// never for more than ACTIVE_MAX_SKIP iterations in a row.
+
+void graph::init_active ( float threshold )
+{
+	active_threshold = threshold;
+	active_x.resize ( num_nodes );
+	active_y.resize ( num_nodes );
+	for ( int i = 0; i < num_nodes; i++ )
+	{
+	  active_x[i] = positions[i].x;
+	  active_y[i] = positions[i].y;
+	}
+	active_moved.assign ( num_nodes, 1 );
+	active.assign ( num_nodes, 1 );
+	active_skip.assign ( num_nodes, 0 );
+	
+	if ( talk () )
+	  cout << "Using active set, threshold = " << active_threshold << "." << endl;
+}
+
+// select_active picks the nodes this proc. moves in the coming
+// iteration.  Positions are the same on every proc., so each proc.
+// can tell which nodes moved; it only needs the neighbors of its own
+// nodes.
+
+void graph::select_active ( )
+{
+	// (every node is moved while the density grid is filled in)
+	bool skip = STAGE >= ACTIVE_FIRST_STAGE && !first_add &&
+				!( fineDensity && fine_first_add );
+	
+	float threshold = active_threshold*active_threshold;
+	for ( int i = 0; i < num_nodes; i++ )
+	{
+	  float x_dis = positions[i].x - active_x[i];
+	  float y_dis = positions[i].y - active_y[i];
+	  active_moved[i] = x_dis*x_dis + y_dis*y_dis >= threshold;
+	  active_x[i] = positions[i].x;
+	  active_y[i] = positions[i].y;
+	}
+	
+	for ( int i = myid; i < num_nodes; i += num_procs )
+	{
+	  bool visit = !skip || active_moved[i] || active_skip[i] >= ACTIVE_MAX_SKIP;
+	  const int *EI = neighbors.Targets ( i );
+	  int num_edges = neighbors.Degree ( i );
+	  for ( int e = 0; !visit && e < num_edges; e++ )
+		visit = active_moved[EI[e]];
+	  
+	  active[i] = visit;
+	  if ( !skip || ( positions[i].fixed && real_fixed ) )
+		continue;
+	  active_updates++;
+	  if ( visit )
+		active_skip[i] = 0;
+	  else
+	  {
+		active_skip[i]++;
+		active_skipped++;
+	  }
+	}
+}
+
+// write_profile writes the profile line of the iteration just done.
+// Timers are totals over threads and procs; seconds is the time the
+// iteration took on proc. 0.  imbalance is the busiest thread (or
+// proc.) over the average, where busy is the time not spent waiting.
+
+void graph::write_profile ( )
+{
+	double seconds = LayoutProfile::Now ( ) - iteration_start;
+	
+	LayoutProfile total;
+	double busy, busy_max = 0, busy_sum = 0;
+	for ( int t = 0; t < num_threads; t++ )
+	{
+		total.Add ( profile[t] );
+		busy = seconds - profile[t].time[PROF_WAIT];
+		busy_max = max ( busy_max, busy );
+		busy_sum += busy;
+	}
+	int workers = num_threads;
+	
+	#ifdef MUSE_MPI
+	  LayoutProfile local = total;
+	  double local_max = busy_max, local_sum = busy_sum;
+	  MPI_Reduce ( local.time, total.time, NUM_PROF_TIMERS, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD );
+	  MPI_Reduce ( local.count, total.count, NUM_PROF_COUNTS, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD );
+	  MPI_Reduce ( &local_max, &busy_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD );
+	  MPI_Reduce ( &local_sum, &busy_sum, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD );
+	  workers *= num_procs;
+	#endif
+	
+	if ( myid == 0 )
+	{
+	  profile_out << tot_iterations << "," << STAGE << "," << seconds << ",";
+	  total.Write ( profile_out );
+	  profile_out << "," << ( busy_sum > 0 ? busy_max*workers/busy_sum : 1.0 ) << endl;
+	}
 }
 
 // The following subroutine reads a .real file to obtain initial
 // coordinates.  If a node is missing coordinates the coordinates
 // are computed 
 
-void graph::read_real ( char *real_file )
+void graph::read_real ( const char *real_file )
 {
   cout << "Processor " << myid << " reading .real file ..." << endl;
   
   // read in .real file and mark as fixed
-  ifstream real_in ( real_file );
-  if ( !real_in )
+  TextReader real_in;
+  if ( !real_in.Open ( real_file ) )
   {
     cout << "Error: proc. " << myid << " could not open .real file." << endl;
     #ifdef MUSE_MPI
@@ -325,16 +620,36 @@ void graph::read_real ( char *real_file )
 	#endif
   }
   
+  vector<Node> real;
   int real_id;
   float real_x, real_y;
-  while ( !real_in.eof () )
+  while ( real_in.Read_Int ( real_id ) && real_in.Read_Float ( real_x ) &&
+		  real_in.Read_Float ( real_y ) )
   {
-    real_id = -1;
-    real_in >> real_id >> real_x >> real_y;
-	if ( real_id >= 0 )
+	real.push_back ( Node ( real_id ) );
+	real.back().x = real_x;
+	real.back().y = real_y;
+  }
+  
+  real_in.Close();
+  set_real ( real );
+}
+
+// set_real places nodes at existing coordinates (given by file id)
+// and marks them as fixed, as read_real does for a .real file.
+
+void graph::set_real ( const vector<Node> &real )
+{
+  int real_id;
+  for ( unsigned int i = 0; i < real.size(); i++ )
+  {
+	// (ids which are not in the .int file are skipped)
+	real_id = real[i].id;
+	if ( (real_id >= 0) && (real_id < (int)id_catalog.size()) &&
+	     (id_catalog[real_id] >= 0) )
 	{
-	  positions[id_catalog[real_id]].x = real_x;
-	  positions[id_catalog[real_id]].y = real_y;
+	  positions[id_catalog[real_id]].x = real[i].x;
+	  positions[id_catalog[real_id]].y = real[i].y;
 	  positions[id_catalog[real_id]].fixed = true;
 	  
 	  /*
@@ -346,76 +661,642 @@ void graph::read_real ( char *real_file )
 	  
 	  // add node to density grid
 	  if ( real_iterations > 0 )
-	    density_server.Add ( positions[id_catalog[real_id]], fineDensity );
+	    density_server->Add ( positions[id_catalog[real_id]], fineDensity );
 	}
 		 
   }
-  
-  real_in.close();
 }
 
-// The read_part_int subroutine reads the .int
-// file produced by convert_sim and gathers the nodes and their
-// neighbors in the range start_ind to end_ind.
+// init_update sets up an incremental layout read by read_update, after
+// the schedule, engine and density server are set up (in place of
+// read_real).  The nodes within hops edges of a changed edge, and the
+// new nodes, are annealed; every other node is held fixed where it
+// was.  New nodes start at the centroid of their neighbors.  The
+// layout then runs a short schedule (see UPDATE_COOLDOWN in layout.h)
+// which starts in the cool-down stage, with the edge cutting of the
+// end of a full layout.  (Fixed nodes have no energy, so the total
+// energy is that of the annealed nodes.)
+
+void graph::init_update ( int hops )
+{
+	
+	// nodes to anneal: ends of changed edges and new nodes, then their
+	// neighborhoods (rows are spread over the procs, and a cut edge may
+	// be left in one row only, so edges are followed both ways)
+	vector<char> moving ( num_nodes, 0 ), next;
+	for ( unsigned int i = 0; i < update_changed.size(); i++ )
+	  moving[update_changed[i]] = 1;
+	for ( int i = 0; i < num_nodes; i++ )
+	  if ( !update_placed[i] )
+		moving[i] = 1;
+	
+	for ( int hop = 0; hop < hops; hop++ )
+	{
+	  next = moving;
+	  for ( int i = 0; i < neighbors.Num_Rows(); i++ )
+	  {
+		const int *targets = neighbors.Targets ( i );
+		for ( int j = 0; j < neighbors.Degree ( i ); j++ )
+		{
+		  if ( moving[i] )
+			next[targets[j]] = 1;
+		  if ( moving[targets[j]] )
+			next[i] = 1;
+		}
+	  }
+	  #ifdef MUSE_MPI
+		MPI_Allreduce ( next.data(), moving.data(), num_nodes, MPI_SIGNED_CHAR, MPI_MAX,
+						MPI_COMM_WORLD );
+	  #else
+		moving.swap ( next );
+	  #endif
+	}
+	
+	place_new_nodes ( update_placed );
+	
+	// hold the rest fixed, in both the coarse and fine density
+	int num_moving = 0, num_new = 0;
+	for ( int i = 0; i < num_nodes; i++ )
+	{
+	  if ( moving[i] )
+	  {
+		num_moving++;
+		continue;
+	  }
+	  positions[i].fixed = true;
+	  density_server->Add ( positions[i], false );
+	  density_server->Add ( positions[i], true );
+	}
+	for ( int i = 0; i < num_nodes; i++ )
+	  num_new += !update_placed[i];
+	
+	// short schedule, starting at the end of expansion
+	cooldown.iterations = UPDATE_COOLDOWN;
+	crunch.iterations = UPDATE_CRUNCH;
+	simmer.iterations = UPDATE_SIMMER;
+	STAGE = 2;
+	iterations = 0;
+	temperature = UPDATE_TEMPERATURE;
+	attraction = cooldown.attraction;
+	damping_mult = cooldown.damping_mult;
+	min_edges = 12;
+	cut_off_length = cut_length_end;
+	
+	// fixed nodes are held for the whole layout
+	real_iterations = UPDATE_COOLDOWN + UPDATE_CRUNCH + UPDATE_SIMMER + 100;
+	real_fixed = true;
+	start_time = LayoutProfile::Now ( );
+	
+	vector<int>().swap ( update_changed );
+	vector<char>().swap ( update_placed );
+	
+	if ( myid == 0 )
+	  cout << "Updating layout: " << num_new << " new nodes, " << num_moving << " of "
+		   << num_nodes << " nodes annealed." << endl
+		   << "Entering cool-down stage ...";
+}
 
-void graph::read_int ( char *file_name )
+// place_new_nodes puts each node without coordinates at the weighted
+// centroid of its placed neighbors (the centroid Solve_Analytic moves
+// nodes to).  This is done in rounds, using only nodes placed in
+// earlier rounds, so chains of new nodes are placed outward from the
+// old graph and every proc. gets the same positions.  Nodes with no
+// path to a placed node are scattered near the origin.
+
+void graph::place_new_nodes ( const vector<char> &was_placed )
 {
+	vector<char> placed ( was_placed );
+	vector<int> unplaced, left, done;
+	for ( int i = 0; i < num_nodes; i++ )
+	  if ( !placed[i] )
+		unplaced.push_back ( i );
+	
+	vector<float> round, total;
+	while ( !unplaced.empty() )
+	{
+	  // (sums for the nodes this proc. owns, which have rows here)
+	  int num_unplaced = unplaced.size();
+	  round.assign ( 3*num_unplaced, 0 );
+	  total.resize ( 3*num_unplaced );
+	  for ( int k = 0; k < num_unplaced; k++ )
+	  {
+		int node_ind = unplaced[k];
+		const int *targets = neighbors.Targets ( node_ind );
+		const float *weights = neighbors.Weights ( node_ind );
+		for ( int j = 0; j < neighbors.Degree ( node_ind ); j++ )
+		  if ( placed[targets[j]] )
+		  {
+			round[3*k] += weights[j] * positions[targets[j]].x;
+			round[3*k+1] += weights[j] * positions[targets[j]].y;
+			round[3*k+2] += weights[j];
+		  }
+	  }
+	  #ifdef MUSE_MPI
+		MPI_Allreduce ( round.data(), total.data(), 3*num_unplaced, MPI_FLOAT, MPI_SUM,
+						MPI_COMM_WORLD );
+	  #else
+		total.swap ( round );
+	  #endif
+	  
+	  left.clear ();
+	  done.clear ();
+	  for ( int k = 0; k < num_unplaced; k++ )
+		if ( total[3*k+2] > 0 )
+		{
+		  positions[unplaced[k]].x = total[3*k] / total[3*k+2];
+		  positions[unplaced[k]].y = total[3*k+1] / total[3*k+2];
+		  done.push_back ( unplaced[k] );
+		}
+		else
+		  left.push_back ( unplaced[k] );
+	  if ( done.empty() )
+		break;
+	  for ( unsigned int k = 0; k < done.size(); k++ )
+		placed[done[k]] = 1;
+	  unplaced.swap ( left );
+	}
+	
+	// (drawn apart from the random jumps of the layout)
+	uint32_t random[4];
+	for ( unsigned int k = 0; k < unplaced.size(); k++ )
+	{
+	  rng.Generate ( 0, positions[unplaced[k]].id, 1, 0, random );
+	  positions[unplaced[k]].x = ( .5 - ( random[0] >> 8 ) / 16777216.0 ) * RADIUS / VIEW_TO_GRID;
+	  positions[unplaced[k]].y = ( .5 - ( random[1] >> 8 ) / 16777216.0 ) * RADIUS / VIEW_TO_GRID;
+	}
+}
+
+// read_int reads the .int file in a single pass.  Proc. 0 reads the
+// file, noting which ids are present and the highest similarity, and
+// keeps (or under MPI sends on) the edges each proc owns -- a node is
+// owned by proc. node % num_procs.  No other proc opens the file.
+// Once every edge is in, the ids are numbered in increasing order
+// (internal ids), the catalog and highest similarity are shared, and
+// the weights are normalized in place.
+
+void graph::read_int ( const char *file_name )
+{
+
+	// edges for this proc in file ids, with raw weights
+	vector<int> rows, cols;
+	vector<float> weights;
+	
+	// seen[file id] is 1 for ids present in the file
+	vector<char> seen;
+	highest_sim = -1.0;
+	
+	if ( myid == 0 )
+	  read_int_edges ( file_name, seen, rows, cols, weights );
+	#ifdef MUSE_MPI
+	else
+	  receive_int_edges ( rows, cols, weights );
+	
+	// share the ids present and highest similarity
+	long num_ids = seen.size();
+	MPI_Bcast ( &num_ids, 1, MPI_LONG, 0, MPI_COMM_WORLD );
+	seen.resize ( num_ids );
+	MPI_Bcast ( seen.data(), num_ids, MPI_CHAR, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( &highest_sim, 1, MPI_FLOAT, 0, MPI_COMM_WORLD );
+	#endif
+	
+	build_neighbors ( file_name, seen, rows, cols, weights );
+}
+
+// read_edges is read_int for a graph already in memory.  Every proc.
+// is given all the edges and keeps the ones it owns.
 
-	ifstream int_file;
+void graph::read_edges ( const vector<EdgeRecord> &edges )
+{
+	vector<int> rows, cols;
+	vector<float> weights;
+	vector<char> seen;
+	highest_sim = -1.0;
 	
-	int_file.open ( file_name );
-	if ( !int_file )
+	int node_1, node_2;
+	float weight;
+	for ( unsigned long i = 0; i < edges.size(); i++ )
 	{
-		cout << "Error (worker process " << myid << "): could not open .int file." << endl;
+		node_1 = edges[i].id1;
+		node_2 = edges[i].id2;
+		weight = edges[i].weight;
+		check_int_edge ( "graph", node_1, node_2, weight, seen );
+		
+		if ( ( node_1 % num_procs ) == myid )
+		{
+			rows.push_back ( node_1 );
+			cols.push_back ( node_2 );
+			weights.push_back ( weight );
+		}
+		if ( ( node_2 % num_procs ) == myid )
+		{
+			rows.push_back ( node_2 );
+			cols.push_back ( node_1 );
+			weights.push_back ( weight );
+		}
+	}
+	
+	build_neighbors ( "graph", seen, rows, cols, weights );
+}
+
+// update_key is an undirected edge as one number (lower id first),
+// so a list of edges can be sorted and searched
+
+static unsigned long long update_key ( int node_1, int node_2 )
+{
+	if ( node_1 > node_2 )
+	  swap ( node_1, node_2 );
+	return ( (unsigned long long)node_1 << 32 ) | (unsigned int)node_2;
+}
+
+// read_update reads the graph and coordinates of an incremental layout.
+// Proc. 0 reads the files.  Each line of delta_file is
+//
+//	node_id <tab> node_id <tab> weight
+//
+// where a weight > 0 adds the edge (or changes its weight) and a weight
+// of 0 removes it.  New nodes should take the next ids in sequence, as
+// ids do in an .int file.  Weights are as in the .iedges file, already
+// normalized, so they are not normalized again.  Every edge in the
+// delta replaces that edge of the .iedges file, in both directions.
+
+void graph::read_update ( const char *coord_file, const char *edges_file,
+						  const char *delta_file )
+{
+	vector<int> rows, cols;
+	vector<float> weights;
+	vector<char> seen;
+	vector<int> coord_ids, changed_ids;
+	vector<float> coord_x, coord_y;
+	highest_sim = 1.0;
+	
+	if ( myid == 0 )
+	{
+	  TextReader coord_in, edges_in, delta_in;
+	  const char *missing = NULL;
+	  if ( !coord_in.Open ( coord_file ) )
+		missing = coord_file;
+	  else if ( !edges_in.Open ( edges_file ) )
+		missing = edges_file;
+	  else if ( !delta_in.Open ( delta_file ) )
+		missing = delta_file;
+	  if ( missing )
+	  {
+		cout << "Error: could not open " << missing << ".  Program terminated." << endl;
 		#ifdef MUSE_MPI
 		  MPI_Abort ( MPI_COMM_WORLD, 1 );
 		#else
 		  exit (1);
 		#endif
+	  }
+	  
+	  cout << "Processor " << myid << " reading previous layout and changes ..." << endl;
+	  
+	  // previous coordinates
+	  int node_1, node_2;
+	  float x, y, weight;
+	  while ( coord_in.Read_Int ( node_1 ) && coord_in.Read_Float ( x ) &&
+			  coord_in.Read_Float ( y ) )
+	  {
+		if ( node_1 < 0 )
+		  continue;
+		coord_ids.push_back ( node_1 );
+		coord_x.push_back ( x );
+		coord_y.push_back ( y );
+		if ( node_1 >= (int)seen.size() )
+		  seen.resize ( node_1 + 1, 0 );
+		seen[node_1] = 1;
+	  }
+	  coord_in.Close ();
+	  
+	  // changed edges (weight 0 removes the edge)
+	  vector<EdgeRecord> delta;
+	  EdgeRecord edge;
+	  while ( delta_in.Read_Int ( node_1 ) && delta_in.Read_Int ( node_2 ) &&
+			  delta_in.Read_Float ( weight ) )
+	  {
+		if ( weight < 0 || node_1 < 0 || node_2 < 0 )
+		{
+		  cout << "Error: found negative node id or weight in " << delta_file
+			   << ".  Program stopped." << endl;
+		  #ifdef MUSE_MPI
+			MPI_Abort ( MPI_COMM_WORLD, 1 );
+		  #else
+			exit (1);
+		  #endif
+		}
+		edge.id1 = node_1;
+		edge.id2 = node_2;
+		edge.weight = weight;
+		delta.push_back ( edge );
+		changed_ids.push_back ( node_1 );
+		changed_ids.push_back ( node_2 );
+	  }
+	  delta_in.Close ();
+	  
+	  vector<unsigned long long> delta_keys ( delta.size() );
+	  for ( unsigned long i = 0; i < delta.size(); i++ )
+		delta_keys[i] = update_key ( delta[i].id1, delta[i].id2 );
+	  sort ( delta_keys.begin(), delta_keys.end() );
+	  
+	  // rows of the previous cut graph (each line is one direction of
+	  // an edge), then the added edges in both directions.  Each end
+	  // goes to the proc. that owns it, as in read_int.
+	  vector< vector<EdgeRecord> > outgoing ( num_procs );
+	  long num_read = 0;
+	  while ( edges_in.Read_Int ( node_1 ) && edges_in.Read_Int ( node_2 ) &&
+			  edges_in.Read_Float ( weight ) )
+	  {
+		if ( binary_search ( delta_keys.begin(), delta_keys.end(), update_key ( node_1, node_2 ) ) )
+		  continue;
+		check_int_edge ( edges_file, node_1, node_2, weight, seen );
+		edge.id1 = node_1;
+		edge.id2 = node_2;
+		edge.weight = weight;
+		outgoing[node_1 % num_procs].push_back ( edge );
+		num_read++;
+	  }
+	  edges_in.Close ();
+	  
+	  for ( unsigned long i = 0; i < delta.size(); i++ )
+		if ( delta[i].weight > 0 && delta[i].id1 != delta[i].id2 )
+		{
+		  check_int_edge ( delta_file, delta[i].id1, delta[i].id2, delta[i].weight, seen );
+		  outgoing[delta[i].id1 % num_procs].push_back ( delta[i] );
+		  swap ( delta[i].id1, delta[i].id2 );
+		  outgoing[delta[i].id1 % num_procs].push_back ( delta[i] );
+		}
+	  
+	  for ( unsigned long i = 0; i < outgoing[0].size(); i++ )
+	  {
+		rows.push_back ( outgoing[0][i].id1 );
+		cols.push_back ( outgoing[0][i].id2 );
+		weights.push_back ( outgoing[0][i].weight );
+	  }
+	  vector<EdgeRecord>().swap ( outgoing[0] );
+	  #ifdef MUSE_MPI
+		send_int_edges ( outgoing, true );
+	  #endif
+	  
+	  cout << "Processor " << myid << " read " << num_read << " previous edges, "
+		   << coord_ids.size() << " coordinates and " << delta.size() << " changed edges." << endl;
 	}
+	#ifdef MUSE_MPI
+	else
+	  receive_int_edges ( rows, cols, weights );
 	
-	cout << "Processor " << myid << " reading .int file ..." << endl;
+	// share the ids present, coordinates and changed nodes
+	long num_ids = seen.size(), num_coords = coord_ids.size(), num_changed = changed_ids.size();
+	MPI_Bcast ( &num_ids, 1, MPI_LONG, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( &num_coords, 1, MPI_LONG, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( &num_changed, 1, MPI_LONG, 0, MPI_COMM_WORLD );
+	seen.resize ( num_ids );
+	coord_ids.resize ( num_coords );
+	coord_x.resize ( num_coords );
+	coord_y.resize ( num_coords );
+	changed_ids.resize ( num_changed );
+	MPI_Bcast ( seen.data(), num_ids, MPI_CHAR, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( coord_ids.data(), num_coords, MPI_INT, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( coord_x.data(), num_coords, MPI_FLOAT, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( coord_y.data(), num_coords, MPI_FLOAT, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( changed_ids.data(), num_changed, MPI_INT, 0, MPI_COMM_WORLD );
+	#endif
 	
-	int node_1, node_2;
-	float weight;
+	build_neighbors ( edges_file, seen, rows, cols, weights, false );
+	init_positions ( );
 	
-    while ( !int_file.eof() )
+	// nodes start where they were
+	update_placed.assign ( num_nodes, 0 );
+	for ( unsigned long i = 0; i < coord_ids.size(); i++ )
 	{
-		weight = 0;		// all weights should be >= 0
-		int_file >> node_1 >> node_2 >> weight;
-		if ( weight )		// otherwise we are at end of file
-								// or it is a self-connected node
+	  int node_ind = id_catalog[coord_ids[i]];
+	  positions[node_ind].x = coord_x[i];
+	  positions[node_ind].y = coord_y[i];
+	  update_placed[node_ind] = 1;
+	}
+	
+	// (ends of removed edges may not be in the graph any more)
+	update_changed.clear ();
+	for ( unsigned long i = 0; i < changed_ids.size(); i++ )
+	  if ( changed_ids[i] < (int)id_catalog.size() && id_catalog[changed_ids[i]] >= 0 )
+		update_changed.push_back ( id_catalog[changed_ids[i]] );
+}
+
+// build_neighbors numbers the ids present (internal ids), translates
+// this proc's edges to internal ids, normalizes the weights (unless
+// they are already normalized, as in an .iedges file) and builds the
+// neighbors structure.
+
+void graph::build_neighbors ( const char *name, vector<char> &seen, vector<int> &rows,
+							  vector<int> &cols, vector<float> &weights, bool normalize )
+{
+	
+	// label nodes with sequential integers starting at 0
+	id_catalog.assign ( seen.size(), -1 );
+	num_nodes = 0;
+	for ( long file_id = 0; file_id < (long)seen.size(); file_id++ )
+	  if ( seen[file_id] )
+	    id_catalog[file_id] = num_nodes++;
+	
+	if ( num_nodes == 0 )
+	{
+		cout << "Error: Proc. " << myid << ": " << name << " is empty.  Program terminated." << endl;
+		#ifdef MUSE_MPI
+		  MPI_Abort ( MPI_COMM_WORLD, 1 );
+		#else
+		  exit (1);
+		#endif
+	}
+	
+	// translate to internal ids and normalize (as in original vxord)
+	float weight;
+	for ( long i = 0; i < (long)rows.size(); i++ )
+	{
+		rows[i] = id_catalog[rows[i]];
+		cols[i] = id_catalog[cols[i]];
+		if ( normalize )
 		{
-			    // normalization from original vxord
-			    weight /= highest_sim;
-				weight = weight*fabs(weight);
-				
-				// initialize graph
-				if ( ( node_1 % num_procs ) == myid )
-					(neighbors[id_catalog[node_1]])[id_catalog[node_2]] = weight;
-				if ( ( node_2 % num_procs ) == myid )
-					(neighbors[id_catalog[node_2]])[id_catalog[node_1]] = weight;
+		  weight = weights[i] / highest_sim;
+		  weights[i] = weight*fabs(weight);
 		}
 	}
-	int_file.close();
+	
+	neighbors.Build ( num_nodes, rows, cols, weights );
 	
 	/*
 	// the following code outputs the contents of the neighbors structure
 	// (to be used for debugging)
 	
-	map<int, map<int,float> >::iterator i;
-	map<int,float>::iterator j;
-	
-	for ( i = neighbors.begin(); i != neighbors.end(); i++ ) {
-	  cout << myid << ": " << i->first << " ";
-		for (j = (i->second).begin(); j != (i->second).end(); j++ )
-			cout << j->first << " (" << j->second << ") ";
+	for ( int i = 0; i < neighbors.Num_Rows(); i++ ) {
+	  cout << myid << ": " << i << " ";
+		for ( int j = 0; j < neighbors.Degree(i); j++ )
+			cout << neighbors.Targets(i)[j] << " (" << neighbors.Weights(i)[j] << ") ";
 		cout << endl;
 		}
-	*/
+	*/
+	
+}
+
+// read_int_edges is the reading half of read_int, run on proc. 0.
+// Edges owned by proc. 0 go straight into rows/cols/weights; under MPI
+// the others are sent out every INT_CHUNK edges.
+
+void graph::read_int_edges ( const char *file_name, vector<char> &seen, vector<int> &rows,
+							 vector<int> &cols, vector<float> &weights )
+{
+
+	EdgeFile int_file;
+	
+	if ( !int_file.Open ( file_name ) )
+	{
+		cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+		#ifdef MUSE_MPI
+		  MPI_Abort ( MPI_COMM_WORLD, 1 );
+		#else
+		  exit (1);
+		#endif
+	}
+	
+	cout << "Processor " << myid << " reading .int file ..." << endl;
+	
+	if ( int_file.Is_Binary() )
+	  seen.reserve ( int_file.Num_Nodes() );
+	
+	// edges waiting to be sent to each proc
+	vector< vector<EdgeRecord> > outgoing ( num_procs );
+	long num_read = 0;
+	
+	int node_1, node_2;
+	float weight;
+	EdgeRecord edge;
+	while ( int_file.Next ( node_1, node_2, weight ) )
+	{
+		check_int_edge ( file_name, node_1, node_2, weight, seen );
+		
+		// each end of the edge goes to the proc that owns it
+		edge.weight = weight;
+		edge.id1 = node_1;
+		edge.id2 = node_2;
+		if ( ( node_1 % num_procs ) == 0 )
+		{
+			rows.push_back ( node_1 );
+			cols.push_back ( node_2 );
+			weights.push_back ( weight );
+		}
+		else
+			outgoing[node_1 % num_procs].push_back ( edge );
+		
+		edge.id1 = node_2;
+		edge.id2 = node_1;
+		if ( ( node_2 % num_procs ) == 0 )
+		{
+			rows.push_back ( node_2 );
+			cols.push_back ( node_1 );
+			weights.push_back ( weight );
+		}
+		else
+			outgoing[node_2 % num_procs].push_back ( edge );
+		
+		num_read++;
+		#ifdef MUSE_MPI
+		if ( num_read % INT_CHUNK == 0 )
+		  send_int_edges ( outgoing, false );
+		#endif
+	}
+	int_file.Close();
+	
+	#ifdef MUSE_MPI
+	  send_int_edges ( outgoing, true );
+	#endif
+	
+	cout << "Processor " << myid << " read " << num_read << " edges." << endl;
+}
+
+// check_int_edge stops on an edge which layout can't use, and notes
+// the ids and highest similarity seen
+
+void graph::check_int_edge ( const char *name, int node_1, int node_2, float weight,
+							 vector<char> &seen )
+{
+	// ignore negative weights!
+	if ( weight <= 0 )
+	{
+		cout << "Error: found negative edge weight in " << name << ".  Program stopped." << endl;
+		#ifdef MUSE_MPI
+		  MPI_Abort ( MPI_COMM_WORLD, 1 );
+		#else
+		  exit (1);
+		#endif
+	}
+	if ( (node_1 < 0) || (node_2 < 0) )
+	{
+		cout << "Error: found negative node id in " << name << ".  Program stopped." << endl;
+		#ifdef MUSE_MPI
+		  MPI_Abort ( MPI_COMM_WORLD, 1 );
+		#else
+		  exit (1);
+		#endif
+	}
+	
+	if ( highest_sim < weight )
+		highest_sim = weight;
+	
+	int top = max ( node_1, node_2 );
+	if ( top >= (int)seen.size() )
+		seen.resize ( top + 1, 0 );
+	seen[node_1] = seen[node_2] = 1;
+}
+
+#ifdef MUSE_MPI
+
+// send_int_edges sends each proc its waiting edges as one message,
+// preceded by the edge count.  A count of -1 marks the end of the
+// .int file.
+
+void graph::send_int_edges ( vector< vector<EdgeRecord> > &outgoing, bool last )
+{
+	for ( int proc = 1; proc < num_procs; proc++ )
+	{
+		int count = outgoing[proc].size();
+		if ( count > 0 )
+		{
+			MPI_Send ( &count, 1, MPI_INT, proc, 0, MPI_COMM_WORLD );
+			MPI_Send ( outgoing[proc].data(), count*sizeof(EdgeRecord), MPI_BYTE,
+					   proc, 0, MPI_COMM_WORLD );
+			outgoing[proc].clear ();
+		}
+		if ( last )
+		{
+			count = -1;
+			MPI_Send ( &count, 1, MPI_INT, proc, 0, MPI_COMM_WORLD );
+		}
+	}
+}
+
+// receive_int_edges collects the edges sent by send_int_edges.
+
+void graph::receive_int_edges ( vector<int> &rows, vector<int> &cols, vector<float> &weights )
+{
+	vector<EdgeRecord> incoming;
+	int count;
 	
+	MPI_Recv ( &count, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+	while ( count >= 0 )
+	{
+		incoming.resize ( count );
+		MPI_Recv ( incoming.data(), count*sizeof(EdgeRecord), MPI_BYTE,
+				   0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+		for ( int i = 0; i < count; i++ )
+		{
+			rows.push_back ( incoming[i].id1 );
+			cols.push_back ( incoming[i].id2 );
+			weights.push_back ( incoming[i].weight );
+		}
+		MPI_Recv ( &count, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE );
+	}
 }
 
+#endif
+
 /*********************************************
  * Function: ReCompute				         *
  * Description: Compute the graph locations	 *
@@ -440,11 +1321,23 @@ int graph::ReCompute( )
 	   << ", fineDensity = " << fineDensity << endl; 
   */
   	    
+  // start the profile of this iteration
+  if ( !profile.empty() )
+  {
+	for ( int t = 0; t < num_threads; t++ )
+	  profile[t].Clear ();
+	iteration_start = LayoutProfile::Now ( );
+  }
+  
   /* Compute Energies for individual nodes */
   update_nodes ();
+  if ( adapt_tol > 0 )
+	track_convergence ();
   
   // check to see if we need to free fixed nodes
   tot_iterations++;
+  if ( !profile.empty() )
+	write_profile ();
   if ( tot_iterations >= real_iterations )
 	 real_fixed = false;
 
@@ -458,22 +1351,22 @@ int graph::ReCompute( )
 
 		if ( iterations == 0 )
 		{
-			start_time = time( NULL );
-			if ( myid == 0 )
+			start_time = LayoutProfile::Now ( );
+			if ( talk () )
 				cout << "Entering liquid stage ...";
 		}
 
-		if (iterations < liquid.iterations) {
+		if ( !stage_done ( liquid ) ) {
 			temperature = liquid.temperature;
 			attraction = liquid.attraction;
 			damping_mult = liquid.damping_mult;
 			iterations++;
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "." << flush;
 		
 		} else {
 
-			stop_time = time( NULL );
+			stop_time = LayoutProfile::Now ( );
 			liquid.time_elapsed = liquid.time_elapsed + (stop_time - start_time);
 			temperature = expansion.temperature;
 			attraction = expansion.attraction;
@@ -481,15 +1374,15 @@ int graph::ReCompute( )
 			iterations = 0;
 
 		    tot_energy = get_tot_energy ();
-			if ( myid == 0 )
+			if ( talk () )
 				cout << endl << "Liquid stage completed in " << liquid.time_elapsed
 					 << " seconds, total energy = " << tot_energy << "." << endl;
 			
 			// go to next stage
 			STAGE = 1;
-			start_time = time( NULL );
+			start_time = LayoutProfile::Now ( );
 			
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "Entering expansion stage ...";
 		}
 	}
@@ -497,7 +1390,7 @@ int graph::ReCompute( )
 	// STAGE 1: EXPANSION
 	if (STAGE == 1) {
 
-		if (iterations < expansion.iterations) {
+		if ( !stage_done ( expansion ) ) {
 				
 			// Play with vars
 			if (attraction > 1) attraction -= .05;
@@ -505,17 +1398,17 @@ int graph::ReCompute( )
 			cut_off_length -= cut_rate;
 			if (damping_mult > .1) damping_mult -= .005;
 			iterations++;
-			if ( myid == 0 ) cout << "." << flush;
+			if ( talk () ) cout << "." << flush;
 	
 		} else {
 
-			stop_time = time( NULL );
+			stop_time = LayoutProfile::Now ( );
 			expansion.time_elapsed = expansion.time_elapsed + (stop_time - start_time);
 		  	min_edges = 12;
 			damping_mult = cooldown.damping_mult;
 			
 			tot_energy = get_tot_energy ();
-			if ( myid == 0 )
+			if ( talk () )
 				cout << endl << "Finished expansion stage in " << expansion.time_elapsed
 					 << " seconds, total energy = " << tot_energy << "." << endl;
 			
@@ -523,9 +1416,9 @@ int graph::ReCompute( )
 			attraction = cooldown.attraction;
 			temperature = cooldown.temperature;
 			iterations = 0;
-			start_time = time( NULL );
+			start_time = LayoutProfile::Now ( );
 			
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "Entering cool-down stage ...";
 		}
 	}
@@ -533,7 +1426,7 @@ int graph::ReCompute( )
 	// STAGE 2: Cool down and cluster
 	else if(STAGE==2) {
 
-		if (iterations < cooldown.iterations) {
+		if ( !stage_done ( cooldown ) ) {
 
 			// Reduce temperature
 			if (temperature > 50) temperature -= 10;
@@ -543,12 +1436,12 @@ int graph::ReCompute( )
 			if (min_edges > MIN) min_edges -= .2;
 			//min_edges = 99;
 			iterations++;
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "." << flush;
 			
 		} else {
 
-			stop_time = time( NULL );
+			stop_time = LayoutProfile::Now ( );
 			cooldown.time_elapsed = cooldown.time_elapsed + (stop_time - start_time);
 			cut_off_length = cut_length_end;
 			temperature = crunch.temperature;
@@ -557,16 +1450,16 @@ int graph::ReCompute( )
 			//min_edges = 99; // In other words: no more cutting
 			
 			tot_energy = get_tot_energy ();
-			if ( myid == 0 )
+			if ( talk () )
 				cout << endl << "Completed cool-down stage in " << cooldown.time_elapsed
 					 << " seconds, total energy = " << tot_energy << "." << endl;
 			
 			STAGE = 3;
 			iterations = 0;
 			attraction = crunch.attraction;
-			start_time = time( NULL );
+			start_time = LayoutProfile::Now ( );
 			
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "Entering crunch stage ...";
 		}  
 	}
@@ -574,14 +1467,14 @@ int graph::ReCompute( )
 	// STAGE 3: Crunch
 	else if(STAGE==3) {
 	
-		if (iterations < crunch.iterations)
+		if ( !stage_done ( crunch ) )
 		{
 			iterations++;
-			if ( myid == 0 ) cout << "." << flush;
+			if ( talk () ) cout << "." << flush;
 		}
 		else {
 		
-			stop_time = time( NULL );
+			stop_time = LayoutProfile::Now ( );
 			crunch.time_elapsed = crunch.time_elapsed + (stop_time - start_time);
 			iterations = 0;
 			temperature = simmer.temperature;
@@ -591,14 +1484,14 @@ int graph::ReCompute( )
 			fineDensity = true;
 			
 			tot_energy = get_tot_energy ();
-			if ( myid == 0 )
+			if ( talk () )
 				cout << endl << "Finished crunch stage in " << crunch.time_elapsed
 					 << " seconds, total energy = " << tot_energy << "." << endl;
 			
 			STAGE = 5;
-			start_time = time( NULL );
+			start_time = LayoutProfile::Now ( );
 				
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "Entering simmer stage ...";
 		}  
 	}
@@ -606,28 +1499,44 @@ int graph::ReCompute( )
 	// STAGE 5: Simmer
 	else if( STAGE==5 ) {
 
-		if (iterations < simmer.iterations) {
+		if ( !stage_done ( simmer ) ) {
 			if (temperature > 50) temperature -= 2;
 			iterations++;
-			if ( myid == 0 ) cout << "." << flush;
+			if ( talk () ) cout << "." << flush;
 		} else {
-			stop_time = time( NULL );
+			stop_time = LayoutProfile::Now ( );
 			simmer.time_elapsed = simmer.time_elapsed + (stop_time - start_time);
 			
 			tot_energy = get_tot_energy();
-			if ( myid == 0 )
+			if ( talk () )
 				cout << endl << "Finished simmer stage in " << simmer.time_elapsed
 					 << " seconds, total energy = "<< tot_energy << "." << endl;
 
 			STAGE = 6;
 			
-			if ( myid == 0 )
+			if ( talk () )
 				cout << "Layout calculation completed in " <<
 				  ( liquid.time_elapsed + expansion.time_elapsed +
 				    cooldown.time_elapsed + crunch.time_elapsed +
 				    simmer.time_elapsed )
 				     << " seconds (not including I/O)." 
 				     << endl;
+			if ( talk () && adapt_tol > 0 )
+				cout << "Adaptive schedule saved " << iterations_saved << " of "
+					 << ( liquid.iterations + expansion.iterations + cooldown.iterations +
+						  crunch.iterations + simmer.iterations )
+					 << " iterations." << endl;
+			if ( active_threshold > 0 )
+			{
+				long counts[2] = { active_skipped, active_updates };
+				#ifdef MUSE_MPI
+				  long my_counts[2] = { active_skipped, active_updates };
+				  MPI_Reduce ( my_counts, counts, 2, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD );
+				#endif
+				if ( talk () )
+					cout << "Active set skipped " << counts[0] << " of " << counts[1]
+						 << " node updates." << endl;
+			}
 		}
 	}
 
@@ -659,10 +1568,32 @@ int graph::ReCompute( )
 // update_nodes -- this function will complete the primary node update
 // loop in layout's recompute routine.  It follows exactly the same
 // sequence to ensure similarity of parallel layout to the standard layout
+// (random jumps come from rng, so they do not depend on the procs)
 
 void graph::update_nodes ( )
 {
 	
+	// (the density tree is rebuilt once per iteration)
+	LayoutProfile *prof = get_profile ( 0 );
+	{
+	  ProfileTimer timer ( prof, PROF_UPDATE );
+	  density_server->Rebuild ();
+	}
+	if ( active_threshold > 0 )
+	  select_active ();
+	
+	if ( num_threads > 1 )
+	{
+	  update_nodes_threaded ();
+	  return;
+	}
+
+	if ( block_size > 1 )
+	{
+	  update_nodes_blocked ();
+	  return;
+	}
+	
 	vector<int> node_indices;			// node list of nodes currently being updated
 	float old_positions[2*MAX_PROCS];	// positions before update
 	float new_positions[2*MAX_PROCS];	// positions after update
@@ -686,29 +1617,9 @@ void graph::update_nodes ( )
 		// default new position is old position
 		get_positions ( node_indices, new_positions );
 		
-		if ( i < num_nodes )
-		{
-
-		  // advance random sequence according to myid
-		  for ( int j = 0; j < 2*myid; j++ )
-		    rand();
-
-		  // calculate node energy possibilities
-		  if ( !(positions[i].fixed && real_fixed) )
-			update_node_pos ( i, old_positions, new_positions );
-
-		  // advance random sequence for next iteration
-		  for ( int j = 2*myid; j < 2*(node_indices.size()-1); j++ )
-		    rand();
-
-		}
-		else
-		{
-		  // advance random sequence according to use by
-		  // the other processors
-		  for ( int j = 0; j < 2*(node_indices.size()); j++ )
-		    rand();
-		}
+		// calculate node energy possibilities
+		if ( i < num_nodes && moves ( i ) )
+		  update_node_pos ( i, &old_positions[2*myid], &new_positions[2*myid] );
 		
 		// check if anything was actually updated (e.g. everything was fixed)
 		all_fixed = true;
@@ -720,8 +1631,13 @@ void graph::update_nodes ( )
 		if ( !all_fixed )
 		{
 		  #ifdef MUSE_MPI
+		  {
+		    ProfileTimer timer ( prof, PROF_WAIT );
   		    MPI_Allgather ( &new_positions[2*myid], 2, MPI_FLOAT,
 			  	            new_positions, 2, MPI_FLOAT, MPI_COMM_WORLD ); 
+		    if ( prof )
+		      prof->count[PROF_BYTES] += 2*num_procs*sizeof(float);
+		  }
 		  #endif
 		
 		  // update positions (old to new)
@@ -753,11 +1669,255 @@ void graph::update_nodes ( )
 	
 }
 
+// update_nodes_blocked -- a version of update_nodes which trades the
+// exact sequential schedule for fewer, larger messages.  Each proc
+// moves block_size of its nodes against the density grid as it stood
+// at the start of the block, then the whole block of block_size*num_procs
+// positions is exchanged in a single MPI_Allgather and applied to the
+// density grid in the same order on every proc.  Nodes are still owned
+// round robin (node i belongs to proc i % num_procs).
+
+void graph::update_nodes_blocked ( )
+{
+
+	int block_nodes = block_size*num_procs;		// nodes per exchange
+	vector<int> node_indices;					// nodes in this block
+	vector<float> old_positions ( 2*block_nodes );	// positions before update
+	vector<float> new_positions ( 2*block_nodes );	// positions after update (by proc)
+	vector<float> old_compact, new_compact;
+	bool all_fixed;
+
+	for ( int block_start = 0; block_start < num_nodes; block_start += block_nodes )
+	{
+
+		// slot p*block_size + j holds the j-th node of proc p,
+		// which is node block_start + p + j*num_procs
+		all_fixed = true;
+		for ( int p = 0; p < num_procs; p++ )
+		  for ( int j = 0; j < block_size; j++ )
+		  {
+			int i = block_start + p + j*num_procs;
+			int slot = p*block_size + j;
+			if ( i < num_nodes )
+			{
+			  old_positions[2*slot] = new_positions[2*slot] = positions[i].x;
+			  old_positions[2*slot+1] = new_positions[2*slot+1] = positions[i].y;
+			  if ( !(positions[i].fixed && real_fixed) )
+			    all_fixed = false;
+			}
+		  }
+
+		// move this proc's nodes
+		for ( int j = 0; j < block_size; j++ )
+		{
+			int i = block_start + myid + j*num_procs;
+			int slot = myid*block_size + j;
+			if ( (i < num_nodes) && moves ( i ) )
+			  update_node_pos ( i, &old_positions[2*slot], &new_positions[2*slot] );
+		}
+
+		if ( all_fixed )
+		  continue;
+
+		// exchange the whole block at once
+		#ifdef MUSE_MPI
+		{
+		  LayoutProfile *prof = get_profile ( 0 );
+		  ProfileTimer timer ( prof, PROF_WAIT );
+		  MPI_Allgather ( MPI_IN_PLACE, 2*block_size, MPI_FLOAT,
+						  &new_positions[0], 2*block_size, MPI_FLOAT, MPI_COMM_WORLD );
+		  if ( prof )
+		    prof->count[PROF_BYTES] += 2*block_nodes*sizeof(float);
+		}
+		#endif
+
+		// collect the slots holding real nodes and update the density grid
+		node_indices.clear ();
+		old_compact.clear ();
+		new_compact.clear ();
+		for ( int slot = 0; slot < block_nodes; slot++ )
+		{
+			int i = block_start + slot / block_size + (slot % block_size)*num_procs;
+			if ( i >= num_nodes )
+			  continue;
+			node_indices.push_back ( i );
+			old_compact.push_back ( old_positions[2*slot] );
+			old_compact.push_back ( old_positions[2*slot+1] );
+			new_compact.push_back ( new_positions[2*slot] );
+			new_compact.push_back ( new_positions[2*slot+1] );
+		}
+		update_density ( node_indices, &old_compact[0], &new_compact[0] );
+
+	}
+
+	// update first_add and fine_first_add
+	first_add = false;
+	if ( fineDensity ) fine_first_add = false;
+
+}
+
+// update_nodes_threaded -- the shared memory version of update_nodes.
+// Nodes are swept in batches of num_threads*THREAD_BATCH.  Within a
+// batch every thread proposes moves for its own THREAD_BATCH nodes
+// against the density grid as it stood at the start of the batch
+// (as the MPI version does for groups of num_procs nodes).  The
+// threads then apply the whole batch to the density grid together,
+// each thread owning a band of grid rows.
+
+void graph::update_nodes_threaded ( )
+{
+	
+	ThreadBarrier barrier ( num_threads );
+	vector<thread> workers;
+	
+	for ( int t = 1; t < num_threads; t++ )
+	  workers.push_back ( thread ( &graph::update_nodes_worker, this, t, ref(barrier) ) );
+	update_nodes_worker ( 0, barrier );
+	for ( unsigned int t = 0; t < workers.size(); t++ )
+	  workers[t].join ();
+	
+	// update first_add and fine_first_add
+	first_add = false;
+	if ( fineDensity ) fine_first_add = false;
+	
+}
+
+// update_nodes_worker -- the work done by a single thread in
+// update_nodes_threaded.
+
+void graph::update_nodes_worker ( int thread_id, ThreadBarrier &barrier )
+{
+	
+	int batch_size = num_threads*THREAD_BATCH;
+	int grid_size = density_server->Grid_Size ();
+	int row_lo = (int)((long)thread_id*grid_size/num_threads);
+	int row_hi = (int)((long)(thread_id+1)*grid_size/num_threads);
+	LayoutProfile *prof = get_profile ( thread_id );
+	
+	for ( int batch_start = 0; batch_start < num_nodes; batch_start += batch_size )
+	{
+		
+		int batch_end = min ( batch_start + batch_size, num_nodes );
+		int my_start = min ( batch_start + thread_id*THREAD_BATCH, batch_end );
+		int my_end = min ( my_start + THREAD_BATCH, batch_end );
+		
+		// propose new positions for this thread's nodes
+		for ( int i = my_start; i < my_end; i++ )
+		{
+			int k = i - batch_start;
+			batch_sub[2*k] = positions[i].sub_x;
+			batch_sub[2*k+1] = positions[i].sub_y;
+			batch_moved[k] = moves ( i );
+			if ( batch_moved[k] )
+			  propose_node_pos ( i, thread_id, batch_pos[2*k], batch_pos[2*k+1] );
+		}
+		
+		{
+		  ProfileTimer timer ( prof, PROF_WAIT );
+		  barrier.Wait ();
+		}
+		
+		// apply every move in the batch to this thread's band of the grid
+		{
+		  ProfileTimer timer ( prof, PROF_UPDATE );
+		  for ( int k = 0; k < batch_end - batch_start; k++ )
+		    if ( batch_moved[k] )
+		    {
+			  Node moved ( positions[batch_start+k].id );
+			  moved.x = batch_pos[2*k];
+			  moved.y = batch_pos[2*k+1];
+			  moved.sub_x = batch_sub[2*k];
+			  moved.sub_y = batch_sub[2*k+1];
+			  density_server->Subtract ( moved, first_add, fine_first_add, fineDensity,
+										row_lo, row_hi );
+			  density_server->Add ( moved, fineDensity, row_lo, row_hi );
+		    }
+		}
+		
+		// nobody else reads positions until the next batch
+		for ( int i = my_start; i < my_end; i++ )
+		{
+			int k = i - batch_start;
+			if ( batch_moved[k] )
+			{
+				positions[i].x = positions[i].sub_x = batch_pos[2*k];
+				positions[i].y = positions[i].sub_y = batch_pos[2*k+1];
+			}
+		}
+		
+		ProfileTimer timer ( prof, PROF_WAIT );
+		barrier.Wait ();
+	}
+	
+}
+
+// propose_node_pos -- the threaded version of update_node_pos.  It
+// leaves positions and the density grid untouched, and instead
+// leaves the node's own contribution out of the density it sees.
+
+void graph::propose_node_pos ( int node_ind, int thread_id,
+							   float &new_x, float &new_y )
+{
+	
+		float energies[2];			// node energies for possible positions
+		float updated_pos[2][2];	// possible positions
+		float pos_x, pos_y;
+		Node *self = NULL;			// node to leave out of density
+		LayoutProfile *prof = get_profile ( thread_id );
+		
+		// old VxOrd parameter
+		float jump_length = .010 * temperature;
+		
+		// has this node already been added to the density grid?
+		if ( fineDensity ? !fine_first_add : !first_add )
+			self = &positions[node_ind];
+		
+		// compute node energy for old solution (as in update_node_pos
+		// this is also the score used for the centroid move)
+		energies[0] = Compute_Edge_Energy ( node_ind, positions[node_ind].x, positions[node_ind].y, prof )
+					+ get_density ( positions[node_ind].x, positions[node_ind].y, self, prof );
+		
+		// move node to centroid position
+		pos_x = positions[node_ind].x;
+		pos_y = positions[node_ind].y;
+		Solve_Analytic ( node_ind, pos_x, pos_y, prof );
+		updated_pos[0][0] = pos_x;
+		updated_pos[0][1] = pos_y;
+		
+		// random jump (as in update_node_pos)
+		float rand_0, rand_1;
+		rng.Uniform ( tot_iterations, positions[node_ind].id, rand_0, rand_1 );
+		updated_pos[1][0] = updated_pos[0][0] + (.5 - rand_0) * jump_length;
+		updated_pos[1][1] = updated_pos[0][1] + (.5 - rand_1) * jump_length;
+		
+		// compute node energy for random position
+		energies[1] = Compute_Edge_Energy ( node_ind, updated_pos[1][0], updated_pos[1][1], prof )
+					+ get_density ( updated_pos[1][0], updated_pos[1][1], self, prof );
+		
+		// choose updated node position with lowest energy
+		if ( energies[0] < energies[1] )
+		{
+			new_x = updated_pos[0][0];
+			new_y = updated_pos[0][1];
+			positions[node_ind].energy = energies[0];
+		}
+		else
+		{
+			new_x = updated_pos[1][0];
+			new_y = updated_pos[1][1];
+			positions[node_ind].energy = energies[1];
+		}
+		
+		if ( prof )
+		  prof->count[PROF_NODES]++;
+		
+}
+
 // The get_positions function takes the node_indices list
 // and returns the corresponding positions in an array.
 
 void graph::get_positions ( vector<int> &node_indices,
-			    float return_positions[2*MAX_PROCS]  )
+			    float *return_positions )
 {
 	
 	// fill positions
@@ -770,13 +1930,9 @@ void graph::get_positions ( vector<int> &node_indices,
 }
 
 // update_node_pos -- this subroutine does the actual work of computing
-// the new position of a given node.  num_act_proc gives the number
-// of active processes at this level for use by the random number
-// generators.
+// the new position of a given node.
 
-void graph::update_node_pos ( int node_ind,
-			      float old_positions[2*MAX_PROCS],
-			      float new_positions[2*MAX_PROCS] )
+void graph::update_node_pos ( int node_ind, float old_pos[2], float new_pos[2] )
 {	
 
 		float energies[2];			// node energies for possible positions
@@ -785,34 +1941,38 @@ void graph::update_node_pos ( int node_ind,
 		
 		// old VxOrd parameter
 		float jump_length = .010 * temperature;
+		LayoutProfile *prof = get_profile ( 0 );
 		
 		// subtract old node
-		density_server.Subtract ( positions[node_ind], first_add, fine_first_add, fineDensity );
+		{
+		  ProfileTimer timer ( prof, PROF_UPDATE );
+		  density_server->Subtract ( positions[node_ind], first_add, fine_first_add, fineDensity );
+		}
 
 		// compute node energy for old solution
-		energies[0] = Compute_Node_Energy ( node_ind );
+		energies[0] = Compute_Node_Energy ( node_ind, prof );
 
 	        // move node to centroid position
-		Solve_Analytic ( node_ind, pos_x, pos_y );
+		Solve_Analytic ( node_ind, pos_x, pos_y, prof );
 		positions[node_ind].x = updated_pos[0][0] = pos_x;
 		positions[node_ind].y = updated_pos[0][1] = pos_y;
 
+		// Do random method (a jump drawn for this iteration and node id)
+		float rand_0, rand_1;
+		rng.Uniform ( tot_iterations, positions[node_ind].id, rand_0, rand_1 );
+		
 		/*
 		// ouput random numbers (for debugging)
-		int rand_0, rand_1;
-		rand_0 = rand();
-		rand_1 = rand();
 		cout << myid << ": " << rand_0 << ", " << rand_1 << endl;
 		*/
-
-		// Do random method (RAND_MAX is C++ maximum random number)
-		updated_pos[1][0] = updated_pos[0][0] + (.5 - rand()/(float)RAND_MAX) * jump_length;
-		updated_pos[1][1] = updated_pos[0][1] + (.5 - rand()/(float)RAND_MAX) * jump_length;
+		
+		updated_pos[1][0] = updated_pos[0][0] + (.5 - rand_0) * jump_length;
+		updated_pos[1][1] = updated_pos[0][1] + (.5 - rand_1) * jump_length;
 		
 		// compute node energy for random position
 		positions[node_ind].x = updated_pos[1][0];
 		positions[node_ind].y = updated_pos[1][1];
-		energies[1] = Compute_Node_Energy ( node_ind );
+		energies[1] = Compute_Node_Energy ( node_ind, prof );
 		
 		/*
 		// output update possiblities (debugging):
@@ -822,24 +1982,29 @@ void graph::update_node_pos ( int node_ind,
 		*/
 			 
 		// add back old position
-		positions[node_ind].x = old_positions[2*myid];
-		positions[node_ind].y = old_positions[2*myid+1];
-		if ( !fineDensity && !first_add )
-			density_server.Add ( positions[node_ind], fineDensity );
-		else if ( !fine_first_add )
-			density_server.Add ( positions[node_ind], fineDensity );
+		positions[node_ind].x = old_pos[0];
+		positions[node_ind].y = old_pos[1];
+		{
+		  ProfileTimer timer ( prof, PROF_UPDATE );
+		  if ( !fineDensity && !first_add )
+			density_server->Add ( positions[node_ind], fineDensity );
+		  else if ( !fine_first_add )
+			density_server->Add ( positions[node_ind], fineDensity );
+		}
+		if ( prof )
+		  prof->count[PROF_NODES]++;
 		
 		// choose updated node position with lowest energy
 		if ( energies[0] < energies[1] )
 		{
-			new_positions[2*myid] = updated_pos[0][0];
-			new_positions[2*myid+1] = updated_pos[0][1];
+			new_pos[0] = updated_pos[0][0];
+			new_pos[1] = updated_pos[0][1];
 			positions[node_ind].energy = energies[0];
 		}
 		else
 		{
-			new_positions[2*myid] = updated_pos[1][0];
-			new_positions[2*myid+1] = updated_pos[1][1];
+			new_pos[0] = updated_pos[1][0];
+			new_pos[1] = updated_pos[1][1];
 			positions[node_ind].energy = energies[1];
 		}
 		
@@ -850,22 +2015,24 @@ void graph::update_node_pos ( int node_ind,
 // new positions to the density grid.
 
 void graph::update_density ( vector<int> &node_indices,
-			     float old_positions[2*MAX_PROCS],
-			     float new_positions[2*MAX_PROCS] )
+			     float *old_positions,
+			     float *new_positions )
 {
 	
 	// go through each node and subtract old position from
 	// density grid before adding new position
+	ProfileTimer timer ( get_profile ( 0 ), PROF_UPDATE );
+	bool skip = !active.empty() && !first_add && !( fineDensity && fine_first_add );
 	for ( unsigned int i = 0; i < node_indices.size(); i++ )
 	{
-		positions[node_indices[i]].x = old_positions[2*i];
-		positions[node_indices[i]].y = old_positions[2*i+1];
-		density_server.Subtract ( positions[node_indices[i]],
-					  first_add, fine_first_add, fineDensity );
-		
+		// (nodes skipped by the active set stay where they are)
+		if ( skip && new_positions[2*i] == old_positions[2*i] &&
+			 new_positions[2*i+1] == old_positions[2*i+1] )
+		  continue;
 		positions[node_indices[i]].x = new_positions[2*i];
 		positions[node_indices[i]].y = new_positions[2*i+1];
-		density_server.Add ( positions[node_indices[i]], fineDensity );
+		density_server->Move ( positions[node_indices[i]],
+				      first_add, fine_first_add, fineDensity );
 	}	
 
 }
@@ -877,27 +2044,69 @@ void graph::update_density ( vector<int> &node_indices,
 * original code by B. Wylie.                *
 *********************************************/
 
-float graph::Compute_Node_Energy( int node_ind )
+float graph::Compute_Node_Energy( int node_ind, LayoutProfile *prof )
+{
+	
+	float node_energy;
+	
+	// Add up all connection energies
+	node_energy = Compute_Edge_Energy ( node_ind, positions[ node_ind ].x, positions[ node_ind ].y,
+										prof );
+
+	// output effect of density (debugging)
+	//cout << "[before: " << node_energy;
+	
+	// add density
+	node_energy += get_density ( positions[ node_ind ].x, positions[ node_ind ].y, NULL, prof );
+
+	// after calling density server (debugging)
+	//cout << ", after: " << node_energy << "]" << endl;
+	
+	// return computated energy
+	return node_energy;
+}
+
+// get_density -- a density query, counted in the profile prof
+
+float graph::get_density ( float pos_x, float pos_y, Node *self, LayoutProfile *prof )
+{
+	if ( !prof )
+	  return density_server->GetDensity ( pos_x, pos_y, fineDensity, self );
+	
+	ProfileTimer timer ( prof, PROF_DENSITY );
+	prof->count[PROF_QUERIES]++;
+	return density_server->GetDensity ( pos_x, pos_y, fineDensity, self,
+									   &prof->count[PROF_BINS] );
+}
+
+// Compute_Edge_Energy -- the attraction part of Compute_Node_Energy
+// with the node placed at (pos_x, pos_y).
+
+float graph::Compute_Edge_Energy( int node_ind, float pos_x, float pos_y, LayoutProfile *prof )
 {
 	
+	ProfileTimer timer ( prof, PROF_EDGE_ENERGY );
+	
 	/* Want to expand 4th power range of attraction */
 	float attraction_factor = attraction*attraction*
 			attraction*attraction*2e-2;
 	
-	map <int,float>::iterator EI;
+	const int *EI = neighbors.Targets ( node_ind );
+	const float *EW = neighbors.Weights ( node_ind );
+	int num_edges = neighbors.Degree ( node_ind );
 	float x_dis,y_dis;
 	float energy_distance, weight;
 	float node_energy=0;
 	
 	// Add up all connection energies
-	for(EI = neighbors[node_ind].begin(); EI != neighbors[node_ind].end(); ++EI) {
+	for( int e = 0; e < num_edges; e++ ) {
 
 		// Get edge weight
-		weight = EI->second;
+		weight = EW[e];
 				
 		// Compute x,y distance
-		x_dis = positions[ node_ind ].x - positions[ EI->first ].x;
-		y_dis = positions[ node_ind ].y - positions[ EI->first ].y;
+		x_dis = pos_x - positions[ EI[e] ].x;
+		y_dis = pos_y - positions[ EI[e] ].y;
 		
 		// Energy Distance
 		energy_distance = x_dis*x_dis + y_dis*y_dis;
@@ -908,18 +2117,10 @@ float graph::Compute_Node_Energy( int node_ind )
 
 		node_energy += weight * attraction_factor * energy_distance;
 	}
-
-	// output effect of density (debugging)
-	//cout << "[before: " << node_energy;
 	
-	// add density
-	node_energy += density_server.GetDensity ( positions[ node_ind ].x, positions[ node_ind ].y,
-											   fineDensity );
+	if ( prof )
+	  prof->count[PROF_EDGES] += num_edges;
 
-	// after calling density server (debugging)
-	//cout << ", after: " << node_energy << "]" << endl;
-	
-	// return computated energy
 	return node_energy;
 }
 
@@ -931,21 +2132,27 @@ float graph::Compute_Node_Energy( int node_ind )
 * originally written by B. Wylie		     *
 *********************************************/
 
-void graph::Solve_Analytic( int node_ind, float &pos_x, float &pos_y )
+void graph::Solve_Analytic( int node_ind, float &pos_x, float &pos_y, LayoutProfile *prof )
 {
 
-   map <int,float>::iterator EI;
+   ProfileTimer timer ( prof, PROF_SOLVE );
+   const int *EI = neighbors.Targets ( node_ind );
+   const float *EW = neighbors.Weights ( node_ind );
+   int num_edges = neighbors.Degree ( node_ind );
    float total_weight = 0;
    float x_dis, y_dis,x_cen=0, y_cen=0;
    float x=0,y=0,dis;
    float damping,weight;
 
+   if ( prof )
+     prof->count[PROF_EDGES] += num_edges;
+
    // Sum up all connections
-   for(EI = neighbors[node_ind].begin(); EI != neighbors[node_ind].end(); ++EI) {
-		weight = EI->second;
+   for( int e = 0; e < num_edges; e++ ) {
+		weight = EW[e];
 		total_weight += weight;
-		x +=  weight * positions[ EI->first ].x;  
-		y +=  weight * positions[ EI->first ].y;
+		x +=  weight * positions[ EI[e] ].x;  
+		y +=  weight * positions[ EI[e] ].y;
    }
 
    // Now set node position
@@ -965,29 +2172,35 @@ void graph::Solve_Analytic( int node_ind, float &pos_x, float &pos_y )
    // Don't cut at end of scale
    if ( CUT_END >= 39500 ) return;
 
-   float num_connections = sqrtf(neighbors[node_ind].size());
+   float num_connections = sqrtf(num_edges);
    float maxLength = 0;
 
-   map<int, float>::iterator maxIndex;
+   int maxIndex = 0;
 
-   // Go through nodes edges... cutting if necessary
-   for(EI = maxIndex = neighbors[node_ind].begin();
-	   EI !=neighbors[node_ind].end(); ++EI) {
+   // Check for at least min edges
+   if (num_edges < min_edges) return;
 
-		// Check for at least min edges
-		if (neighbors[node_ind].size() < min_edges) continue;
+   // Go through nodes edges... cutting if necessary
+   for( int e = 0; e < num_edges; e++ ) {
 
-		x_dis = x_cen - positions[ EI->first ].x;
-		y_dis = y_cen - positions[ EI->first ].y;
+		x_dis = x_cen - positions[ EI[e] ].x;
+		y_dis = y_cen - positions[ EI[e] ].y;
 		dis = x_dis*x_dis+y_dis*y_dis;
 		dis *= num_connections;
 
 		// Store maximum edge
-		if (dis > maxLength) {maxLength = dis; maxIndex=EI;}
+		if (dis > maxLength) {maxLength = dis; maxIndex=e;}
    }
 
+   if ( prof )
+     prof->count[PROF_EDGES] += num_edges;
+
    // If max length greater than cut_length then cut
-   if (maxLength > cut_off_length) neighbors[ node_ind ].erase( maxIndex ); 
+   if (maxLength > cut_off_length) {
+     neighbors.Cut ( node_ind, maxIndex );
+     if ( prof )
+       prof->count[PROF_CUTS]++;
+   }
    
 }
 
@@ -1049,19 +2262,261 @@ void graph::write_sim ( const char *file_name )
       
   // the following code outputs the contents of the neighbors structure
 
-  map<int, map<int,float> >::iterator i;
-  map<int,float>::iterator j;
-  
-  for ( i = neighbors.begin(); i != neighbors.end(); i++ )
-    for (j = (i->second).begin(); j != (i->second).end(); j++ )
-	simOUT << positions[i->first].id << "\t"
-	       << positions[j->first].id << "\t"
-	       << j->second << endl;
+  for ( int i = 0; i < neighbors.Num_Rows(); i++ )
+    for ( int j = 0; j < neighbors.Degree(i); j++ )
+	simOUT << positions[i].id << "\t"
+	       << positions[neighbors.Targets(i)[j]].id << "\t"
+	       << neighbors.Weights(i)[j] << endl;
 
   simOUT.close();
 
 }
 
+// get_coord returns the node positions (by file id), as written
+// by write_coord
+
+void graph::get_coord ( vector<Node> &coord )
+{
+  coord.assign ( positions.begin(), positions.end() );
+}
+
+// get_sim returns this proc's part of the (cut) graph in file ids,
+// as written by write_sim
+
+void graph::get_sim ( vector<EdgeRecord> &edges )
+{
+  EdgeRecord edge;
+  edges.clear ();
+  for ( int i = 0; i < neighbors.Num_Rows(); i++ )
+    for ( int j = 0; j < neighbors.Degree(i); j++ )
+	{
+	  edge.id1 = positions[i].id;
+	  edge.id2 = positions[neighbors.Targets(i)[j]].id;
+	  edge.weight = neighbors.Weights(i)[j];
+	  edges.push_back ( edge );
+	}
+}
+
+// checkpoint_name is the checkpoint file of this proc.: file_name
+// itself for a single proc., otherwise file_name.<proc. id>
+
+static string checkpoint_name ( const char *file_name, int proc_id, int tot_procs )
+{
+  string name = file_name;
+  if ( tot_procs > 1 )
+  {
+	char suffix[MAX_INT_LENGTH+2];
+	sprintf ( suffix, ".%d", proc_id );
+	name = name + suffix;
+  }
+  return name;
+}
+
+// write_checkpoint saves the state of the layout between iterations:
+// the schedule, node positions, neighbors left by edge cutting and
+// the density server.  Every proc. writes its own file.  The file is
+// written under a temporary name and then renamed, so an existing
+// checkpoint is only replaced by a complete one.
+
+void graph::write_checkpoint ( const char *file_name )
+{
+  string name = checkpoint_name ( file_name, myid, num_procs );
+  string temp_name = name + ".tmp";
+  
+  ofstream out ( temp_name.c_str(), ios::binary );
+  if ( !out )
+  {
+	cout << "Could not open " << temp_name << ".  Program terminated." << endl;
+	#ifdef MUSE_MPI
+	  MPI_Abort ( MPI_COMM_WORLD, 1 );
+	#else
+	  exit (1);
+	#endif
+  }
+  
+  CheckpointHeader header;
+  memset ( &header, 0, sizeof(header) );
+  strcpy ( header.magic, CHECKPOINT_MAGIC );
+  header.version = CHECKPOINT_VERSION;
+  header.num_procs = num_procs;
+  header.proc_id = myid;
+  header.num_nodes = num_nodes;
+  write_value ( out, header );
+  
+  // schedule (the time spent in the current stage is kept, as the
+  // stage clock will be restarted)
+  double stage_time = LayoutProfile::Now ( ) - start_time;
+  write_value ( out, STAGE );
+  write_value ( out, iterations );
+  write_value ( out, temperature );
+  write_value ( out, attraction );
+  write_value ( out, damping_mult );
+  write_value ( out, min_edges );
+  write_value ( out, CUT_END );
+  write_value ( out, cut_length_end );
+  write_value ( out, cut_off_length );
+  write_value ( out, cut_rate );
+  write_value ( out, first_add );
+  write_value ( out, fine_first_add );
+  write_value ( out, fineDensity );
+  write_value ( out, liquid );
+  write_value ( out, expansion );
+  write_value ( out, cooldown );
+  write_value ( out, crunch );
+  write_value ( out, simmer );
+  write_value ( out, stage_time );
+  write_value ( out, real_iterations );
+  write_value ( out, tot_iterations );
+  write_value ( out, real_fixed );
+  write_value ( out, rng );
+  write_value ( out, adapt_tol );
+  write_vector ( out, adapt_energy );
+  write_vector ( out, adapt_displacement );
+  write_value ( out, iterations_saved );
+  write_value ( out, active_threshold );
+  write_vector ( out, active_x );
+  write_vector ( out, active_y );
+  write_vector ( out, active_skip );
+  write_value ( out, active_skipped );
+  write_value ( out, active_updates );
+  
+  // graph
+  write_vector ( out, positions );
+  neighbors.Write ( out );
+  density_server->Write ( out );
+  
+  out.close ();
+  if ( !out || rename ( temp_name.c_str(), name.c_str() ) != 0 )
+  {
+	cout << "Could not write " << name << ".  Program terminated." << endl;
+	#ifdef MUSE_MPI
+	  MPI_Abort ( MPI_COMM_WORLD, 1 );
+	#else
+	  exit (1);
+	#endif
+  }
+  
+  if ( talk () )
+	cout << endl << "Wrote checkpoint " << file_name << " at iteration "
+		 << tot_iterations << "." << endl;
+}
+
+// read_checkpoint restores a layout saved by write_checkpoint.  The
+// graph, number of procs. and density server (grid or tree, and its
+// size) must be those of the saved layout.  The random seed is taken
+// from the checkpoint.  With the same engine options the layout then
+// goes on exactly as it would have without stopping.
+
+void graph::read_checkpoint ( const char *file_name )
+{
+  string name = checkpoint_name ( file_name, myid, num_procs );
+  
+  ifstream in ( name.c_str(), ios::binary );
+  if ( !in )
+  {
+	cout << "Error: proc. " << myid << " could not open " << name << "." << endl;
+	#ifdef MUSE_MPI
+	  MPI_Abort ( MPI_COMM_WORLD, 1 );
+	#else
+	  exit (1);
+	#endif
+  }
+  
+  CheckpointHeader header;
+  bool ok = read_value ( in, header ) &&
+			strncmp ( header.magic, CHECKPOINT_MAGIC, sizeof(header.magic) ) == 0 &&
+			header.version == CHECKPOINT_VERSION;
+  if ( ok && ( header.num_procs != num_procs || header.proc_id != myid ||
+			   header.num_nodes != num_nodes ) )
+  {
+	cout << "Error: " << name << " is a checkpoint of a different graph or number of processors."
+		 << endl;
+	#ifdef MUSE_MPI
+	  MPI_Abort ( MPI_COMM_WORLD, 1 );
+	#else
+	  exit (1);
+	#endif
+  }
+  
+  double stage_time = 0;
+  ok = ok && read_value ( in, STAGE ) && read_value ( in, iterations ) &&
+	   read_value ( in, temperature ) && read_value ( in, attraction ) &&
+	   read_value ( in, damping_mult ) && read_value ( in, min_edges ) &&
+	   read_value ( in, CUT_END ) && read_value ( in, cut_length_end ) &&
+	   read_value ( in, cut_off_length ) && read_value ( in, cut_rate ) &&
+	   read_value ( in, first_add ) && read_value ( in, fine_first_add ) &&
+	   read_value ( in, fineDensity ) && read_value ( in, liquid ) &&
+	   read_value ( in, expansion ) && read_value ( in, cooldown ) &&
+	   read_value ( in, crunch ) && read_value ( in, simmer ) &&
+	   read_value ( in, stage_time ) && read_value ( in, real_iterations ) &&
+	   read_value ( in, tot_iterations ) && read_value ( in, real_fixed ) &&
+	   read_value ( in, rng ) && read_value ( in, adapt_tol ) &&
+	   read_vector ( in, adapt_energy ) && read_vector ( in, adapt_displacement ) &&
+	   read_value ( in, iterations_saved ) && read_value ( in, active_threshold ) &&
+	   read_vector ( in, active_x ) && read_vector ( in, active_y ) &&
+	   read_vector ( in, active_skip ) && read_value ( in, active_skipped ) &&
+	   read_value ( in, active_updates );
+  
+  // positions must be of the same nodes
+  vector<Node> saved ( positions );
+  ok = ok && read_array ( in, saved.data(), saved.size() );
+  for ( unsigned int i = 0; ok && i < positions.size(); i++ )
+	ok = saved[i].id == positions[i].id;
+  if ( ok )
+	positions.swap ( saved );
+  
+  int num_rows = neighbors.Num_Rows ();
+  ok = ok && neighbors.Read ( in ) && neighbors.Num_Rows() == num_rows;
+  ok = ok && density_server->Read ( in );
+  
+  // (positions before the next iteration are the current ones)
+  if ( ok && adapt_tol > 0 )
+  {
+	adapt_x.resize ( num_nodes );
+	adapt_y.resize ( num_nodes );
+	for ( int i = 0; i < num_nodes; i++ )
+	{
+	  adapt_x[i] = positions[i].x;
+	  adapt_y[i] = positions[i].y;
+	}
+  }
+  if ( ok && active_threshold > 0 )
+  {
+	active_moved.assign ( num_nodes, 1 );
+	active.assign ( num_nodes, 1 );
+  }
+  if ( !ok )
+  {
+	cout << "Error: could not read checkpoint " << name
+		 << " (or it does not match the layout options)." << endl;
+	#ifdef MUSE_MPI
+	  MPI_Abort ( MPI_COMM_WORLD, 1 );
+	#else
+	  exit (1);
+	#endif
+  }
+  in.close ();
+  start_time = LayoutProfile::Now ( ) - stage_time;
+  
+  // procs. must resume from the same iteration
+  #ifdef MUSE_MPI
+	int first, last;
+	MPI_Allreduce ( &tot_iterations, &first, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD );
+	MPI_Allreduce ( &tot_iterations, &last, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+	if ( first != last )
+	{
+	  if ( myid == 0 )
+		cout << "Error: checkpoint files of " << file_name
+			 << " are from different iterations." << endl;
+	  MPI_Abort ( MPI_COMM_WORLD, 1 );
+	}
+  #endif
+  
+  if ( talk () )
+	cout << "Resuming layout from " << file_name << " at iteration "
+		 << tot_iterations << " (stage " << STAGE << ")." << endl;
+}
+
 // get_tot_energy adds up the energy for each node to give an estimate of the
 // quality of the minimization.
 
@@ -2,15 +2,25 @@
 // graph.  It calls on the density server class to obtain
 // position and density information
 
+#include <fstream>
+
 #include <DensityGrid.h>
+#include <DensityTree.h>
+#include <CSRAdjacency.h>
+#include <EdgeFile.h>
+#include <ThreadBarrier.h>
+#include <LayoutProfile.h>
+#include <Rng.h>
 
 // layout schedule information
 struct layout_schedule {
 	int iterations;
+	int min_iterations;		// fewest iterations with an adaptive schedule
+							// (-1 for ADAPT_MIN_FRACTION of iterations)
 	float temperature;
 	float attraction;
 	float damping_mult;
-	time_t time_elapsed;
+	double time_elapsed;
 };
 
 class graph {
@@ -19,46 +29,103 @@ public:
 
     // Methods
 	void init_parms ( int rand_seed, float edge_cut, float real_parm );
-    void read_parms ( char *parms_file );
-	void read_real ( char *real_file );
-	void scan_int ( char *filename );
-	void read_int ( char *file_name );
+	void init_engine ( int threads, int block );
+	void init_grid ( int grid_size, float theta = 0.0 );
+	void init_profile ( const char *profile_file );
+	void init_adaptive ( float tolerance );
+	void init_active ( float threshold );
+    void read_parms ( const char *parms_file );
+	void read_real ( const char *real_file );
+	void set_real ( const vector<Node> &real );
+	void init_update ( int hops );
+	void read_int ( const char *file_name );
+	void read_edges ( const vector<EdgeRecord> &edges );
 	void draw_graph ( int int_out, char *coord_file );
+	int ReCompute ( );		// one iteration (returns 0 when done)
 	void write_coord ( const char *file_name );
 	void write_sim ( const char *file_name );
+	void get_coord ( vector<Node> &coord );
+	void get_sim ( vector<EdgeRecord> &edges );
+	void write_checkpoint ( const char *file_name );
+	void read_checkpoint ( const char *file_name );
 	float get_tot_energy ( );
+	int get_stage ( ) { return STAGE; }
+	int get_iterations ( ) { return tot_iterations; }
+	int get_num_nodes ( ) { return num_nodes; }
+	void set_quiet ( bool no_output ) { quiet = no_output; }
 	
 	// Con/Decon
-	graph( int proc_id, int tot_procs, char *int_file );
-		~graph( ) { }
+	graph( int proc_id, int tot_procs, const char *int_file );
+	graph( int proc_id, int tot_procs, const vector<EdgeRecord> &edges );
+	graph( int proc_id, int tot_procs, const char *coord_file, const char *edges_file,
+		   const char *delta_file );
+	graph( const graph &loaded );
+		~graph( ) { delete density_server; }
 	
 private:
 
 	// Methods
-	int ReCompute ( );
+	void init_schedule ( int proc_id, int tot_procs );
+	void init_positions ( );
+	void check_int_edge ( const char *name, int node_1, int node_2, float weight,
+						  vector<char> &seen );
+	void build_neighbors ( const char *name, vector<char> &seen, vector<int> &rows,
+						   vector<int> &cols, vector<float> &weights, bool normalize = true );
+	void read_update ( const char *coord_file, const char *edges_file,
+					   const char *delta_file );
+	void place_new_nodes ( const vector<char> &was_placed );
+	void read_int_edges ( const char *file_name, vector<char> &seen, vector<int> &rows,
+						  vector<int> &cols, vector<float> &weights );
+	void send_int_edges ( vector< vector<EdgeRecord> > &outgoing, bool last );
+	void receive_int_edges ( vector<int> &rows, vector<int> &cols, vector<float> &weights );
 	void update_nodes ( );
-	float Compute_Node_Energy ( int node_ind );
-	void Solve_Analytic ( int node_ind, float &pos_x, float &pos_y );
-	void get_positions ( vector<int> &node_indices, float return_positions[2*MAX_PROCS] );
-	void update_density ( vector<int> &node_indices, float old_positions[2*MAX_PROCS],
-			      float new_positions[2*MAX_PROCS] );
-	void update_node_pos ( int node_ind,
-			       float old_positions[2*MAX_PROCS],
-			       float new_positions[2*MAX_PROCS] );
+	void update_nodes_blocked ( );
+	void update_nodes_threaded ( );
+	void update_nodes_worker ( int thread_id, ThreadBarrier &barrier );
+	void propose_node_pos ( int node_ind, int thread_id, float &new_x, float &new_y );
+	float Compute_Node_Energy ( int node_ind, LayoutProfile *prof );
+	float Compute_Edge_Energy ( int node_ind, float pos_x, float pos_y, LayoutProfile *prof );
+	float get_density ( float pos_x, float pos_y, Node *self, LayoutProfile *prof );
+	void Solve_Analytic ( int node_ind, float &pos_x, float &pos_y, LayoutProfile *prof );
+	void get_positions ( vector<int> &node_indices, float *return_positions );
+	void update_density ( vector<int> &node_indices, float *old_positions,
+			      float *new_positions );
+	void update_node_pos ( int node_ind, float old_pos[2], float new_pos[2] );
+	void write_profile ( );
+	void track_convergence ( );
+	bool stage_done ( const layout_schedule &stage );
+	void select_active ( );
+	bool moves ( int node_ind )		// (not fixed, and in the active set)
+	  { return !(positions[node_ind].fixed && real_fixed) &&
+			   ( active.empty() || active[node_ind] ); }
+	bool talk ( ) const { return myid == 0 && !quiet; }	// (progress output)
+	LayoutProfile *get_profile ( int thread_id )
+	  { return profile.empty() ? NULL : &profile[thread_id]; }
 								  
 	// MPI information
 	int myid, num_procs;
+	bool quiet;				// no progress output (layout_trials)
+	int block_size;			// nodes per proc between position exchanges
+	
+	// threaded engine information
+	int num_threads;
+	vector<float> batch_pos;			// chosen positions for current batch
+	vector<float> batch_sub;			// density grid positions for current batch
+	vector<char> batch_moved;			// batch nodes which are not fixed
 	
 	// graph decomposition information
 	int num_nodes;					// number of nodes in graph
 	float highest_sim;				// highest sim for normalization
-	map <int, int> id_catalog;		// id_catalog[file id] = internal id
-	map <int, map <int, float> > neighbors;		// neighbors of nodes on this proc.
+	vector<int> id_catalog;			// id_catalog[file id] = internal id (-1 if absent)
+	CSRAdjacency neighbors;			// neighbors of nodes on this proc.
 	
 	// graph layout information
 	vector<Node> positions;  
-	DensityGrid density_server;
+	DensityServer *density_server;	// DensityGrid, or DensityTree for theta > 0
   
+	// random jumps, keyed by the seed and drawn by (iteration, node id)
+	CounterRng rng;
+	
 	// original VxOrd information
 	int STAGE, iterations;
 	float temperature, attraction, damping_mult;
@@ -73,10 +140,37 @@ private:
 	layout_schedule simmer;
 	
 	// timing statistics
-        time_t start_time, stop_time;
+        double start_time, stop_time;
+	
+	// profiling (layout -m): one profile per thread, empty when off
+	vector<LayoutProfile> profile;
+	ofstream profile_out;			// .prof file (proc. 0)
+	double iteration_start;
+	
+	// adaptive schedule (layout -a): a stage ends early once total
+	// energy and mean displacement level off
+	float adapt_tol;				// relative change per iteration (0 = off)
+	vector<double> adapt_energy;	// last 2*ADAPT_WINDOW iterations of the stage
+	vector<double> adapt_displacement;
+	vector<float> adapt_x, adapt_y;	// positions before the iteration
+	int iterations_saved;
+	
+	// active set (layout -x): nodes which moved less than the threshold,
+	// as did their neighbors, are skipped for a few iterations
+	float active_threshold;			// distance counted as a move (0 = off)
+	vector<float> active_x, active_y;	// positions before the iteration
+	vector<char> active_moved;		// nodes which moved in the last iteration
+	vector<char> active;			// nodes of this proc. to move
+	vector<int> active_skip;		// iterations in a row each node was skipped
+	long active_skipped, active_updates;	// node updates skipped and due
 	
 	// online clustering information
 	int real_iterations;    // number of iterations to hold .real input fixed
 	int tot_iterations;
 	bool real_fixed;
+	
+	// incremental layout information (layout -u), kept from reading
+	// the previous layout until init_update
+	vector<int> update_changed;		// nodes at the ends of changed edges
+	vector<char> update_placed;		// nodes with previous coordinates
 };
@@ -22,19 +22,71 @@
 #include <vector>
 #include <cstdlib>
 #include <cstring>
+#include <csignal>
 
 using namespace std;
 
 // layout routines and constants
 #include <layout.h>
 #include <parse.h>
-#include <graph.h>
+#include <liblayout.h>
 
 // MPI
 #ifdef MUSE_MPI
   #include <mpi.h>
 #endif
 
+// intermediate output, written every int_out iterations, and
+// checkpoints, written every checkpoint_interval iterations, by the
+// layout callback.  Both go by the iteration count, so a resumed
+// layout writes the same files as an uninterrupted one.
+
+struct layout_output {
+  int int_out;
+  const char *coord_file;
+  int checkpoint_out, checkpoint_interval;
+  const char *checkpoint_file;
+};
+
+// set by SIGTERM (with -k): a checkpoint is written after the current
+// iteration and the layout stops
+
+static volatile sig_atomic_t terminate_requested = 0;
+
+static void request_checkpoint ( int )
+{
+  terminate_requested = 1;
+}
+
+bool write_output ( drl_layout &layout, int iteration, void *user_data )
+{
+  layout_output *out = (layout_output *)user_data;
+  if ( (out->int_out > 0) && (iteration % (out->int_out+1) == 0) )
+  {
+	// output intermediate solution
+	char int_coord_file [MAX_FILE_NAME + MAX_INT_LENGTH];
+	sprintf ( int_coord_file, "%s.%d", out->coord_file, iteration / (out->int_out+1) );
+	layout.write_coord ( int_coord_file );
+  }
+  
+  if ( out->checkpoint_out )
+  {
+	// every proc. stops if any was sent SIGTERM
+	int terminate = terminate_requested;
+	#ifdef MUSE_MPI
+	  int my_terminate = terminate;
+	  MPI_Allreduce ( &my_terminate, &terminate, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD );
+	#endif
+	if ( terminate ||
+		 ( (out->checkpoint_interval > 0) && (iteration % out->checkpoint_interval == 0) ) )
+	  layout.write_checkpoint ( out->checkpoint_file );
+	if ( terminate )
+	  return false;
+  }
+	
+  return true;
+}
+
 int main(int argc, char **argv) {
   
   
@@ -58,11 +110,28 @@ int main(int argc, char **argv) {
   char coord_file[MAX_FILE_NAME];
   char real_file[MAX_FILE_NAME];
   char parms_file[MAX_FILE_NAME];
+  char profile_file[MAX_FILE_NAME];
+  char checkpoint_file[MAX_FILE_NAME];
+  char delta_file[MAX_FILE_NAME];
+  char update_coord_file[MAX_FILE_NAME];
+  char update_edges_file[MAX_FILE_NAME];
   
   int int_out = 0;
   int edges_out = 0;
+  int profile_out = 0;
   int parms_in = 0;
   float real_in = -1.0;
+  int num_threads = 1;
+  int block_size = 1;
+  int grid_size = 0;
+  float theta = 0.0;
+  int checkpoint_out = 0;
+  int checkpoint_interval = 0;
+  int resume = 0;
+  int update_in = 0;
+  int update_hops = 2;
+  float adapt_tol = 0.0;
+  float active_threshold = 0.0;
   
   // user interaction is handled by processor 0
   if ( myid == 0 )
@@ -84,43 +153,100 @@ int main(int argc, char **argv) {
 	edge_cut = command_line.edge_cut;
 	int_out = command_line.int_out;
 	edges_out = command_line.edges_out;
+	profile_out = command_line.profile_out;
 	parms_in = command_line.parms_in;
 	real_in = command_line.real_in;
+	num_threads = command_line.num_threads;
+	block_size = command_line.block_size;
+	grid_size = command_line.grid_size;
+	theta = command_line.theta;
+	checkpoint_out = command_line.checkpoint_out;
+	checkpoint_interval = command_line.checkpoint_interval;
+	resume = command_line.resume;
+	update_in = command_line.update_in;
+	update_hops = command_line.update_hops;
+	adapt_tol = command_line.adapt_tol;
+	active_threshold = command_line.active_threshold;
+	
+	// threads and MPI are separate engines
+	if ( (num_threads > 1) && (num_procs > 1) )
+	{
+		cout << "Error: -t cannot be used with more than one MPI process." << endl;
+		#ifdef MUSE_MPI
+		  MPI_Abort ( MPI_COMM_WORLD, 1 );
+		#else
+		  exit (1);
+		#endif
+	}
 	strcpy ( coord_file, command_line.coord_file.c_str() );
 	strcpy ( int_file, command_line.sim_file.c_str() );
 	strcpy ( real_file, command_line.real_file.c_str() );
 	strcpy ( parms_file, command_line.parms_file.c_str() );
+	strcpy ( profile_file, command_line.profile_file.c_str() );
+	strcpy ( checkpoint_file, command_line.checkpoint_file.c_str() );
+	strcpy ( delta_file, command_line.delta_file.c_str() );
+	strcpy ( update_coord_file, command_line.update_coord_file.c_str() );
+	strcpy ( update_edges_file, command_line.update_edges_file.c_str() );
 	
   }
   
   // now we initialize all processors by reading .int file
   #ifdef MUSE_MPI
     MPI_Bcast ( &int_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
-  #endif
-  graph neighbors ( myid, num_procs, int_file );
-  
-  // check for user supplied parameters
-  #ifdef MUSE_MPI
-    MPI_Bcast ( &parms_in, 1, MPI_INT, 0, MPI_COMM_WORLD );
-  #endif
-  if ( parms_in )
-  {
-    #ifdef MUSE_MPI
-	  MPI_Bcast ( &parms_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
-	#endif
-	neighbors.read_parms ( parms_file );
-  }
-
-  // set random seed, edge cutting, and real iterations parameters
-  #ifdef MUSE_MPI
+	MPI_Bcast ( &parms_in, 1, MPI_INT, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( &parms_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
     MPI_Bcast ( &rand_seed, 1, MPI_INT, 0, MPI_COMM_WORLD );
     MPI_Bcast ( &edge_cut, 1, MPI_FLOAT, 0, MPI_COMM_WORLD );
-	MPI_Bcast ( &real_in, 1, MPI_INT, 0, MPI_COMM_WORLD );
+	MPI_Bcast ( &real_in, 1, MPI_FLOAT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &num_threads, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &block_size, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &grid_size, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &theta, 1, MPI_FLOAT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &profile_out, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &profile_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &checkpoint_out, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &checkpoint_interval, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &resume, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &checkpoint_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &update_in, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &update_hops, 1, MPI_INT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &adapt_tol, 1, MPI_FLOAT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &active_threshold, 1, MPI_FLOAT, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &delta_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &update_coord_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
+    MPI_Bcast ( &update_edges_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
   #endif
-  neighbors.init_parms ( rand_seed, edge_cut, real_in );
+  
+  // set up schedule, engine and density grid
+  layout_options options;
+  options.parms_file = parms_in ? parms_file : NULL;
+  options.rand_seed = rand_seed;
+  options.edge_cut = edge_cut;
+  options.real_parm = real_in;
+  options.num_threads = num_threads;
+  options.block_size = block_size;
+  options.grid_size = grid_size;
+  options.theta = theta;
+  options.profile_file = profile_out ? profile_file : NULL;
+  options.update_hops = update_hops;
+  options.adapt_tol = adapt_tol;
+  options.active_threshold = active_threshold;
+  options.proc_id = myid;
+  options.num_procs = num_procs;
+  
+  // (an update reads the previous layout and changes instead of .int)
+  drl_layout *layout;
+  if ( update_in )
+    layout = new drl_layout ( update_coord_file, update_edges_file, delta_file, options );
+  else
+    layout = new drl_layout ( int_file, options );
+  drl_layout &neighbors = *layout;
 
-  // check for .real file with existing coordinates
-  if ( real_in >= 0 )
+  // check for .real file with existing coordinates (a checkpoint
+  // already holds them)
+  if ( resume )
+    neighbors.read_checkpoint ( checkpoint_file );
+  else if ( real_in >= 0 )
   {
     #ifdef MUSE_MPI
 	  MPI_Bcast ( &real_file, MAX_FILE_NAME, MPI_CHAR, 0, MPI_COMM_WORLD );
@@ -128,7 +254,28 @@ int main(int argc, char **argv) {
 	neighbors.read_real ( real_file );
   }
   
-  neighbors.draw_graph ( int_out, coord_file );
+  // layout graph (with possible intermediate output on proc. 0, and
+  // checkpoints on every proc.)
+  layout_output output;
+  output.int_out = int_out;
+  output.coord_file = coord_file;
+  output.checkpoint_out = checkpoint_out;
+  output.checkpoint_interval = checkpoint_interval;
+  output.checkpoint_file = checkpoint_file;
+  if ( checkpoint_out )
+    signal ( SIGTERM, request_checkpoint );
+  if ( (int_out > 0) || checkpoint_out )
+    neighbors.set_callback ( write_output, &output );
+  if ( !neighbors.run ( ) )
+  {
+    if ( myid == 0 )
+	  cout << "Layout stopped by SIGTERM.  Use --resume to continue from "
+		   << checkpoint_file << "." << endl;
+	#ifdef MUSE_MPI
+	  MPI_Finalize ();
+	#endif
+	exit (1);
+  }
 
   // do we have to write out the edges?
   #ifdef MUSE_MPI
@@ -159,6 +306,8 @@ int main(int argc, char **argv) {
 	     << "Program terminated successfully." << endl;
   }
 
+  delete layout;
+  
   // MPI finalize
   #ifdef MUSE_MPI
     MPI_Finalize ();
@@ -7,20 +7,58 @@
 #define MAX_PROCS 256	   // maximum number of processors
 #define MAX_FILE_NAME 250   // max length of filename
 #define MAX_INT_LENGTH 4   // max length of integer suffix of intermediate .coord file
+#define INT_CHUNK 1048576  // .int edges read by proc. 0 between sends to other procs
+
+// compile time parameters for the threaded engine
+#define MAX_THREADS 1024   // maximum number of threads
+#define THREAD_BATCH 32	   // nodes each thread moves between density updates
 
 // Compile time adjustable parameters for the Density grid
 
-#define GRID_SIZE 1000			// size of Density grid
-#define VIEW_SIZE 4000.0		// actual physical size of layout plane
-								// these values use more memory but have
-								// little effect on performance or layout
-								
+// The grid size is picked at run time from the number of nodes (see
+// DensityGrid::Init) or given with layout -g.  The physical size of
+// the layout plane is grid size / VIEW_TO_GRID.
+
+#define GRID_PER_NODE 3.0		// grid size is GRID_PER_NODE*sqrt(nodes)
+#define MIN_GRID_SIZE 400		// smallest automatic grid size
+#define MAX_GRID_SIZE 40000		// largest grid size (Density and bin
+								// index need 8 bytes per grid cell)
+
 #define RADIUS 10				// radius for density fall-off:
 								// larger values tends to slow down
 								// the program and clump the data
 
-#define HALF_VIEW 2000			// 1/2 of VIEW_SIZE
-#define VIEW_TO_GRID .25		// ratio of GRID_SIZE to VIEW_SIZE
+#define VIEW_TO_GRID .25		// grid cells per unit of layout plane
+
+// Compile time parameters for the Barnes-Hut density tree (layout -q).
+// The tree allocates nothing per grid cell, so its plane is limited
+// only by float precision.
+
+#define MAX_TREE_GRID_SIZE 1000000	// largest plane (in grid cells) for the tree
+#define TREE_LEAF_SIZE 8			// nodes in a tree cell before it is split
+#define TREE_MAX_DEPTH 24			// deepest tree cell (stops splitting
+									// when many nodes share a position)
+
+// Compile time parameters for the adaptive schedule (layout -a)
+
+#define ADAPT_WINDOW 10				// iterations averaged to compare energy
+									// and displacement
+#define ADAPT_MIN_FRACTION .25		// default fewest iterations of a stage,
+									// as a fraction of its iterations
+
+// Compile time parameters for the active set (layout -x)
+
+#define ACTIVE_FIRST_STAGE 2		// first stage nodes are skipped in (cool-down)
+#define ACTIVE_MAX_SKIP 4			// most iterations in a row a node is skipped
+
+// Compile time parameters for incremental layout (layout -u).  Only
+// the neighborhoods of changed edges are annealed, with a short
+// schedule starting in the cool-down stage at a lower temperature.
+
+#define UPDATE_TEMPERATURE 250		// starting temperature
+#define UPDATE_COOLDOWN 50			// cool-down iterations
+#define UPDATE_CRUNCH 25			// crunch iterations
+#define UPDATE_SIMMER 50			// simmer iterations
 
 /*
 // original values for VxOrd
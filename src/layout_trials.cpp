@@ -0,0 +1,243 @@
+// Layout Trials
+//
+// This program lays out one graph several times, with different random
+// seeds, edge cutting or .parms schedules, so the best layout can be
+// picked.  The .int file is read once; each trial copies the graph
+// (with its own density grid) and the trials are shared out among
+// worker threads, each taking the next trial as it finishes one.
+//
+// The structure of the inputs and outputs of this code will be displayed
+// if the program is called without parameters, or if an erroneous
+// parameter is passed to the program.
+
+// C++ library routines
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+
+using namespace std;
+
+// layout routines and constants
+#include <layout_trials_parse.h>
+#include <liblayout.h>
+#include <LayoutProfile.h>
+
+// MPI
+#ifdef MUSE_MPI
+  #include <mpi.h>
+#endif
+
+// one layout of the graph (energy and seconds are filled in by run_trials)
+
+struct layout_trial {
+  int seed;
+  float edge_cut;
+  string parms_file;		// "" for the default schedule
+  float energy;
+  double seconds;
+};
+
+// trials are shared out by run_trials
+
+struct trial_queue {
+  const drl_layout *loaded;		// the graph, as read
+  const parse *command_line;
+  vector<layout_trial> *trials;
+  atomic<int> next;				// next trial to start
+  mutex output;					// (guards cout)
+};
+
+// read_trials reads a trials file, one "seed edge_cut [parms_file]"
+// line per trial
+
+static void read_trials ( const string &trials_file, vector<layout_trial> &trials )
+{
+  ifstream in ( trials_file.c_str() );
+  if ( !in )
+  {
+    cout << "Error: could not open " << trials_file << ".  Program terminated." << endl;
+    #ifdef MUSE_MPI
+      MPI_Abort ( MPI_COMM_WORLD, 1 );
+    #else
+      exit (1);
+    #endif
+  }
+
+  string line;
+  int line_number = 0;
+  while ( getline ( in, line ) )
+  {
+    line_number++;
+    istringstream fields ( line );
+    layout_trial trial;
+    if ( !(fields >> trial.seed) )
+      continue;				// (blank line)
+    if ( !(fields >> trial.edge_cut) || (trial.seed < 0) ||
+         (trial.edge_cut < 0) || (trial.edge_cut > 1) )
+    {
+      cout << "Error: bad trial on line " << line_number << " of " << trials_file
+           << ".  Program terminated." << endl;
+      #ifdef MUSE_MPI
+        MPI_Abort ( MPI_COMM_WORLD, 1 );
+      #else
+        exit (1);
+      #endif
+    }
+    fields >> trial.parms_file;
+    trials.push_back ( trial );
+  }
+
+  if ( trials.empty() )
+  {
+    cout << "Error: " << trials_file << " has no trials.  Program terminated." << endl;
+    #ifdef MUSE_MPI
+      MPI_Abort ( MPI_COMM_WORLD, 1 );
+    #else
+      exit (1);
+    #endif
+  }
+}
+
+// run_trials is the work of one worker thread: it lays out trials
+// until there are none left
+
+static void run_trials ( trial_queue *queue )
+{
+  const parse &command_line = *queue->command_line;
+  vector<layout_trial> &trials = *queue->trials;
+
+  for ( int k = queue->next++; k < (int)trials.size(); k = queue->next++ )
+  {
+    layout_trial &trial = trials[k];
+
+    layout_options options;
+    options.rand_seed = trial.seed;
+    options.edge_cut = trial.edge_cut;
+    if ( !trial.parms_file.empty() )
+      options.parms_file = trial.parms_file.c_str();
+    options.num_threads = command_line.num_threads;
+    options.quiet = true;
+
+    double start = LayoutProfile::Now ( );
+    drl_layout layout ( *queue->loaded, options );
+    layout.run ( );
+    trial.seconds = LayoutProfile::Now ( ) - start;
+    trial.energy = layout.get_tot_energy ( );
+
+    // (writing reports to cout too)
+    lock_guard<mutex> lock ( queue->output );
+    ostringstream coord_file;
+    coord_file << command_line.root_file << ".t" << k << ".icoord";
+    if ( command_line.edges_out )
+      layout.write_sim ( coord_file.str().c_str() );
+    layout.write_coord ( coord_file.str().c_str() );
+    cout << "Trial " << k << " (seed " << trial.seed << ", edge cut " << trial.edge_cut
+         << ") finished in " << trial.seconds << " seconds, total energy = "
+         << trial.energy << "." << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+
+  // the layout engine is built for MPI, but trials run on one process
+  #ifdef MUSE_MPI
+    int num_procs;
+    MPI_Init ( &argc, &argv );
+    MPI_Comm_size ( MPI_COMM_WORLD, &num_procs );
+    if ( num_procs > 1 )
+    {
+      cout << "Error: layout_trials runs on one MPI process." << endl;
+      MPI_Abort ( MPI_COMM_WORLD, 1 );
+    }
+  #endif
+
+  parse command_line ( argc, argv );
+
+  // the trials: from the trials file, or -n seeds in a row
+  vector<layout_trial> trials;
+  if ( !command_line.trials_file.empty() )
+    read_trials ( command_line.trials_file, trials );
+  else
+    for ( int k = 0; k < command_line.num_trials; k++ )
+    {
+      layout_trial trial;
+      trial.seed = command_line.rand_seed + k;
+      trial.edge_cut = command_line.edge_cut;
+      if ( command_line.parms_in )
+        trial.parms_file = command_line.parms_file;
+      trials.push_back ( trial );
+    }
+
+  // enough workers to keep every core busy (the engine makes MPI
+  // calls, so an MPI build runs one trial at a time)
+  int num_workers = command_line.num_workers;
+  if ( num_workers == 0 )
+  {
+    num_workers = (int)thread::hardware_concurrency ( ) / command_line.num_threads;
+    if ( num_workers < 1 )
+      num_workers = 1;
+  }
+  #ifdef MUSE_MPI
+    num_workers = 1;
+  #endif
+  if ( num_workers > (int)trials.size() )
+    num_workers = trials.size();
+
+  cout << "Running " << trials.size() << " trials, " << num_workers << " at a time with "
+       << command_line.num_threads << " thread(s) each." << endl;
+
+  // read the graph once
+  layout_options options;
+  drl_layout loaded ( command_line.int_file.c_str(), options );
+
+  trial_queue queue;
+  queue.loaded = &loaded;
+  queue.command_line = &command_line;
+  queue.trials = &trials;
+  queue.next = 0;
+
+  vector<thread> workers;
+  for ( int w = 1; w < num_workers; w++ )
+    workers.push_back ( thread ( run_trials, &queue ) );
+  run_trials ( &queue );
+  for ( unsigned int w = 0; w < workers.size(); w++ )
+    workers[w].join ();
+
+  // summary, and the best trial
+  ofstream summary ( command_line.summary_file.c_str() );
+  if ( !summary )
+  {
+    cout << "Error: could not open " << command_line.summary_file << ".  Program terminated." << endl;
+    #ifdef MUSE_MPI
+      MPI_Abort ( MPI_COMM_WORLD, 1 );
+    #else
+      exit (1);
+    #endif
+  }
+  int best = 0;
+  for ( unsigned int k = 0; k < trials.size(); k++ )
+  {
+    summary << k << "\t" << trials[k].seed << "\t" << trials[k].edge_cut << "\t"
+            << ( trials[k].parms_file.empty() ? "-" : trials[k].parms_file ) << "\t"
+            << trials[k].energy << "\t" << trials[k].seconds << endl;
+    if ( trials[k].energy < trials[best].energy )
+      best = k;
+  }
+  summary.close ();
+
+  cout << "Wrote " << command_line.summary_file << ".  Lowest energy: trial " << best
+       << " (" << command_line.root_file << ".t" << best << ".icoord), total energy = "
+       << trials[best].energy << "." << endl;
+
+  #ifdef MUSE_MPI
+    MPI_Finalize ();
+  #endif
+
+  return 0;
+}
@@ -0,0 +1,170 @@
+// This file contains the methods for the layout_trials_parse.h class
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+#include <layout.h>
+#include <layout_trials_parse.h>
+#ifdef MUSE_MPI
+  #include <mpi.h>
+#endif
+
+void parse::print_syntax( const char *error_string )
+{
+  cout << endl << "Error: " << error_string << endl;
+  cout << endl << "Layout Trials" << endl
+	   <<     "-------------" << endl
+	   << "Version " << VERSION << endl << endl
+	   << "This program reads a graph once and lays it out several times," << endl
+	   << "with different random seeds, edge cutting or schedules, to pick" << endl
+	   << "the best layout.  Trials run side by side, each with its own" << endl
+	   << "density grid, as many at once as there are cores." << endl << endl
+	   << "Usage: layout_trials [options] root_file" << endl << endl
+	   << "root_file -- the root name of the file being processed." << endl << endl
+	   << "INPUT" << endl
+	   << "-----" << endl
+	   << "root_file.int -- the graph to draw, as for layout." << endl << endl
+	   << "OUTPUT" << endl
+	   << "------" << endl
+	   << "root_file.t<k>.icoord -- the layout of trial k (k = 0, 1, ...), as" << endl
+	   << "  layout writes root_file.icoord (and root_file.t<k>.iedges with -e)." << endl << endl
+	   << "root_file.trials -- one line per trial of the form" << endl
+	   << "\ttrial <tab> seed <tab> edge_cut <tab> parms_file <tab> energy <tab> seconds" << endl
+	   << "  where energy is the total energy at the end of the layout (lower" << endl
+	   << "  is better) and parms_file is - for the default schedule." << endl << endl
+	   << "Options:" << endl << endl
+	   << "\t-n {int>=1} number of trials, with seeds s, s+1, ... (default 4)" << endl
+	   << "\t-s {int>=0} random seed of the first trial (default 0)" << endl
+	   << "\t-c {real[0,1]} edge cutting of every trial (default 32/40 = .8)" << endl
+	   << "\t-p input parameters of every trial from root_file.parms" << endl
+	   << "\t-f {trials_file} run the trials listed in trials_file instead," << endl
+	   << "\t   one per line of the form" << endl
+	   << "\t\tseed <tab> edge_cut [<tab> parms_file]" << endl
+	   << "\t-t {int>=1} threads for each trial (default 1)" << endl
+	   << "\t-w {int>=1} trials run at once (default: number of cores / -t)" << endl
+	   << "\t   (built with MPI, trials run one at a time on one process)" << endl
+	   << "\t-e output .iedges files" << endl << endl;
+
+  #ifdef MUSE_MPI
+    MPI_Abort ( MPI_COMM_WORLD, 1 );
+  #else
+    exit (1);
+  #endif
+}
+
+parse::parse ( int argc, char** argv)
+{
+
+  if ( argc < 2 )
+	print_syntax ( "not enough arguments!" );
+
+  // all input/output files use same root
+  root_file = argv[argc-1];
+  int_file = root_file + ".int";
+  parms_file = root_file + ".parms";
+  summary_file = root_file + ".trials";
+
+  // set defaults
+  num_trials = 4;
+  rand_seed = 0;
+  edge_cut = 32.0/40.0;
+  parms_in = false;
+  num_threads = 1;
+  num_workers = 0;
+  edges_out = false;
+
+  // now check for optional arguments
+  string arg;
+  for( int i = 1; i<argc-1; i++ )
+  {
+	arg = argv[i];
+
+	// check for number of trials
+	if ( arg == "-n" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-n flag has no argument." );
+		else
+		{
+			num_trials = atoi ( argv[i] );
+			if ( num_trials < 1 )
+				print_syntax ( "number of trials must be >= 1." );
+		}
+	}
+	// check for random seed
+	else if ( arg == "-s" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-s flag has no argument." );
+		else
+		{
+			rand_seed = atoi ( argv[i] );
+			if ( rand_seed < 0 )
+				print_syntax ( "random seed must be >= 0." );
+		}
+	}
+	// check for edge cutting
+	else if ( arg == "-c" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-c flag has no argument." );
+		else
+		{
+			edge_cut = atof ( argv[i] );
+			if ( (edge_cut < 0) || (edge_cut > 1) )
+				print_syntax ( "edge cut must be between 0 and 1." );
+		}
+	}
+	// check for trials file
+	else if ( arg == "-f" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-f flag has no argument." );
+		else
+			trials_file = argv[i];
+	}
+	// check for threads per trial
+	else if ( arg == "-t" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-t flag has no argument." );
+		else
+		{
+			num_threads = atoi ( argv[i] );
+			if ( num_threads < 1 )
+				print_syntax ( "number of threads must be >= 1." );
+		}
+	}
+	// check for trials at once
+	else if ( arg == "-w" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-w flag has no argument." );
+		else
+		{
+			num_workers = atoi ( argv[i] );
+			if ( num_workers < 1 )
+				print_syntax ( "number of trials at once must be >= 1." );
+		}
+	}
+	else if ( arg == "-p" )
+		parms_in = true;
+	else if ( arg == "-e" )
+		edges_out = true;
+	else
+		print_syntax ( "unrecongized option!" );
+  }
+
+  if ( !trials_file.empty() && parms_in )
+	print_syntax ( "-f and -p cannot be used together (give parms files in the trials file)." );
+
+}
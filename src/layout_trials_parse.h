@@ -0,0 +1,37 @@
+// The parse class contains the methods necessary to parse
+// the command line, print help, and do error checking
+
+#ifndef PARSEH
+#define PARSEH
+
+class parse {
+
+public:
+
+    // Methods
+
+	parse ( int argc, char **argv );
+	~parse () {}
+
+	// user parameters
+	string root_file;		// root name of the project
+	string int_file;		// .int file (input)
+	string parms_file;		// .parms file (input)
+	string trials_file;		// trials to run (input, "" for -n trials)
+	string summary_file;	// .trials file (output)
+
+	int num_trials;			// trials with seeds rand_seed, rand_seed+1, ...
+	int rand_seed;			// random seed of the first trial, int >= 0
+	float edge_cut;			// edge cutting real [0,1]
+	bool parms_in;			// true to use the .parms file
+	int num_threads;		// threads for each trial, int >= 1
+	int num_workers;		// trials run at once (0 to fill the cores)
+	bool edges_out;			// true to output .iedges files
+
+private:
+
+	void print_syntax ( const char *error_string );
+
+};
+
+#endif
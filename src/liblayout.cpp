@@ -0,0 +1,230 @@
+// This file contains the methods for the drl_layout class (liblayout.h)
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#include <graph.h>
+#include <liblayout.h>
+
+// constructor for a graph given as an edge array (one entry per edge)
+
+drl_layout::drl_layout ( int num_edges, const int *ids_1, const int *ids_2,
+						 const float *weights, const layout_options &options )
+{
+	vector<EdgeRecord> edges ( num_edges );
+	for ( int i = 0; i < num_edges; i++ )
+	{
+		edges[i].id1 = ids_1[i];
+		edges[i].id2 = ids_2[i];
+		edges[i].weight = weights[i];
+	}
+	engine = new graph ( options.proc_id, options.num_procs, edges );
+	init ( options );
+}
+
+// constructor for a graph in CSR form: the edges of node i are
+// columns[row_offsets[i]] to columns[row_offsets[i+1]-1].  As for an
+// edge array, each edge is given once, in the row of either end.
+
+drl_layout::drl_layout ( int num_ids, const long *row_offsets, const int *columns,
+						 const float *weights, const layout_options &options )
+{
+	vector<EdgeRecord> edges ( row_offsets[num_ids] - row_offsets[0] );
+	long edge = 0;
+	for ( int i = 0; i < num_ids; i++ )
+	  for ( long j = row_offsets[i]; j < row_offsets[i+1]; j++ )
+	  {
+		edges[edge].id1 = i;
+		edges[edge].id2 = columns[j];
+		edges[edge].weight = weights[j];
+		edge++;
+	  }
+	engine = new graph ( options.proc_id, options.num_procs, edges );
+	init ( options );
+}
+
+// constructor for a graph in an .int file (text or binary)
+
+drl_layout::drl_layout ( const char *int_file, const layout_options &options )
+{
+	engine = new graph ( options.proc_id, options.num_procs, int_file );
+	init ( options );
+}
+
+// constructor for an incremental layout: the previous layout's .icoord
+// and .iedges files, and the changed edges (see graph::read_update)
+
+drl_layout::drl_layout ( const char *coord_file, const char *edges_file,
+						 const char *delta_file, const layout_options &options )
+{
+	engine = new graph ( options.proc_id, options.num_procs, coord_file, edges_file,
+						 delta_file );
+	init ( options );
+	engine->init_update ( options.update_hops );
+}
+
+// constructor for another layout of the graph of a layout which has
+// not been run (only the graph is copied; the two layouts are then
+// independent)
+
+drl_layout::drl_layout ( const drl_layout &loaded, const layout_options &options )
+{
+	engine = new graph ( *loaded.engine );
+	init ( options );
+}
+
+drl_layout::~drl_layout ( )
+{
+	delete engine;
+}
+
+// init sets up the schedule, engine, density grid and profiling, as
+// the layout program does before reading a .real file
+
+void drl_layout::init ( const layout_options &options )
+{
+	callback = 0;
+	user_data = 0;
+	stop = false;
+
+	engine->set_quiet ( options.quiet );
+	if ( options.parms_file )
+	  engine->read_parms ( options.parms_file );
+	engine->init_parms ( options.rand_seed, options.edge_cut, options.real_parm );
+	engine->init_engine ( options.num_threads, options.block_size );
+	engine->init_grid ( options.grid_size, options.theta );
+	if ( options.profile_file )
+	  engine->init_profile ( options.profile_file );
+	if ( options.adapt_tol > 0 )
+	  engine->init_adaptive ( options.adapt_tol );
+	if ( options.active_threshold > 0 )
+	  engine->init_active ( options.active_threshold );
+}
+
+// set_real places nodes at the given x,y positions (and holds them
+// for the fraction of the layout given by layout_options.real_parm)
+
+void drl_layout::set_real ( int num_real, const int *ids, const float *positions )
+{
+	vector<Node> real;
+	real.reserve ( num_real );
+	for ( int i = 0; i < num_real; i++ )
+	{
+	  real.push_back ( Node ( ids[i] ) );
+	  real.back().x = positions[2*i];
+	  real.back().y = positions[2*i+1];
+	}
+	engine->set_real ( real );
+}
+
+void drl_layout::read_real ( const char *real_file )
+{
+	engine->read_real ( real_file );
+}
+
+void drl_layout::set_callback ( layout_callback new_callback, void *new_user_data )
+{
+	callback = new_callback;
+	user_data = new_user_data;
+}
+
+// run lays out the graph.  The callback (if any) is made after each
+// iteration, and the layout stops early if it is cancelled.  Under MPI
+// every proc. must cancel at the same iteration.
+
+bool drl_layout::run ( )
+{
+	while ( !stop && engine->ReCompute ( ) )
+	  if ( callback && !callback ( *this, engine->get_iterations ( ), user_data ) )
+		stop = true;
+
+	return !stop;
+}
+
+// cancel stops a layout at the end of the current iteration (it may
+// be called from the callback or from another thread)
+
+void drl_layout::cancel ( )
+{
+	stop = true;
+}
+
+int drl_layout::num_nodes ( )
+{
+	return engine->get_num_nodes ( );
+}
+
+// get_positions returns the node ids (num_nodes) and x,y positions
+// (2*num_nodes), in increasing order of id
+
+void drl_layout::get_positions ( int *ids, float *positions )
+{
+	vector<Node> coord;
+	engine->get_coord ( coord );
+	for ( unsigned int i = 0; i < coord.size(); i++ )
+	{
+	  ids[i] = coord[i].id;
+	  positions[2*i] = coord[i].x;
+	  positions[2*i+1] = coord[i].y;
+	}
+}
+
+// num_edges and get_edges return the graph left by edge cutting, as
+// written to the .iedges file (each edge from both ends, and under MPI
+// only the nodes owned by this proc.)
+
+int drl_layout::num_edges ( )
+{
+	vector<EdgeRecord> edges;
+	engine->get_sim ( edges );
+	return edges.size();
+}
+
+void drl_layout::get_edges ( int *ids_1, int *ids_2, float *weights )
+{
+	vector<EdgeRecord> edges;
+	engine->get_sim ( edges );
+	for ( unsigned long i = 0; i < edges.size(); i++ )
+	{
+	  ids_1[i] = edges[i].id1;
+	  ids_2[i] = edges[i].id2;
+	  weights[i] = edges[i].weight;
+	}
+}
+
+// (the total energy is summed on proc. 0 under MPI)
+
+float drl_layout::get_tot_energy ( )
+{
+	return engine->get_tot_energy ( );
+}
+
+int drl_layout::get_stage ( )
+{
+	return engine->get_stage ( );
+}
+
+void drl_layout::write_coord ( const char *coord_file )
+{
+	engine->write_coord ( coord_file );
+}
+
+void drl_layout::write_sim ( const char *coord_file )
+{
+	engine->write_sim ( coord_file );
+}
+
+// checkpoints are written between iterations (from the callback) and
+// read before run; under MPI every proc. makes the same call
+
+void drl_layout::write_checkpoint ( const char *checkpoint_file )
+{
+	engine->write_checkpoint ( checkpoint_file );
+}
+
+void drl_layout::read_checkpoint ( const char *checkpoint_file )
+{
+	engine->read_checkpoint ( checkpoint_file );
+}
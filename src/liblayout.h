@@ -0,0 +1,120 @@
+// liblayout is the DrL layout engine as a library.  A drl_layout
+// holds one graph, given as an edge array, in CSR form, or as an .int
+// file, and lays it out.  Positions and the edges left after edge
+// cutting are returned in caller supplied buffers, so no files are
+// needed.  A callback can watch each iteration, and a layout can be
+// cancelled between iterations (from the callback or another thread).
+//
+// A graph read once can be laid out many times: a drl_layout made from
+// another (which has not been run) copies its graph instead of reading
+// it again, and the copies can be run side by side in threads.
+//
+// A layout can also be updated: given the .icoord and .iedges files
+// of a previous layout and a list of changed edges, only the nodes
+// near the changes are laid out again, with a short schedule.
+//
+// Node ids are those of the edges given (ids >= 0, as in an .int file).
+// Each edge is given once -- the graph is undirected -- and weights
+// must be positive.  Nodes without edges are not part of the layout.
+//
+// The layout program (layout.cpp) is the command line front end of
+// this library.
+
+#ifndef LIBLAYOUTH
+#define LIBLAYOUTH
+
+#include <atomic>
+
+class graph;
+class drl_layout;
+
+// options for a layout (the defaults are those of the layout program)
+
+struct layout_options {
+	const char *parms_file;	// .parms file for the schedule (NULL for default)
+	int rand_seed;			// random seed, int >= 0
+	float edge_cut;			// edge cutting, real [0,1]
+	float real_parm;		// fraction of iterations to hold real positions
+							// fixed (-1 for no real positions)
+	int num_threads;		// threads for the threaded engine
+	int block_size;			// nodes per proc between MPI position exchanges
+	int grid_size;			// density grid size (0 to size from the graph)
+	float theta;			// Barnes-Hut opening angle (0 for the density grid)
+	const char *profile_file;	// per-iteration timings and counts, as
+								// layout -m writes them (NULL for none)
+	int update_hops;		// neighborhood of changed edges annealed by an
+							// update, in edges
+	float adapt_tol;		// relative change in energy and displacement at
+							// which a stage ends early (0 for the fixed schedule)
+	float active_threshold;	// distance a node must move to stay in the active
+							// set (0 to move every node every iteration)
+	bool quiet;				// no progress output (for layouts run side by side)
+	int proc_id;			// MPI rank and number of procs (0 and 1
+	int num_procs;			// without MPI)
+
+	layout_options ( ) : parms_file ( 0 ), rand_seed ( 0 ), edge_cut ( 32.0/40.0 ),
+		real_parm ( -1.0 ), num_threads ( 1 ), block_size ( 1 ), grid_size ( 0 ), theta ( 0.0 ),
+		profile_file ( 0 ), update_hops ( 2 ), adapt_tol ( 0.0 ),
+		active_threshold ( 0.0 ), quiet ( false ), proc_id ( 0 ), num_procs ( 1 ) { }
+};
+
+// callback made after each iteration of a layout, with the number of
+// iterations done so far.  Returning false cancels the layout.
+
+typedef bool (*layout_callback) ( drl_layout &layout, int iteration, void *user_data );
+
+class drl_layout {
+
+public:
+
+	// Methods
+	void set_real ( int num_real, const int *ids, const float *positions );
+	void read_real ( const char *real_file );
+	void set_callback ( layout_callback callback, void *user_data );
+	bool run ( );			// false if the layout was cancelled
+	void cancel ( );
+	bool cancelled ( ) const { return stop; }
+
+	// results (positions are x,y pairs in the order of the ids; edges
+	// are those left by edge cutting, as in the .iedges file)
+	int num_nodes ( );
+	void get_positions ( int *ids, float *positions );
+	int num_edges ( );
+	void get_edges ( int *ids_1, int *ids_2, float *weights );
+	float get_tot_energy ( );
+	int get_stage ( );
+	void write_coord ( const char *coord_file );
+	void write_sim ( const char *coord_file );
+
+	// checkpoints: the whole layout state, one file per proc. (file
+	// name.<proc. id> under MPI).  A layout read from a checkpoint
+	// with the same options goes on exactly as the saved one would.
+	void write_checkpoint ( const char *checkpoint_file );
+	void read_checkpoint ( const char *checkpoint_file );
+
+	// Con/Decon
+	drl_layout ( int num_edges, const int *ids_1, const int *ids_2, const float *weights,
+				 const layout_options &options );
+	drl_layout ( int num_ids, const long *row_offsets, const int *columns,
+				 const float *weights, const layout_options &options );
+	drl_layout ( const char *int_file, const layout_options &options );
+	drl_layout ( const char *coord_file, const char *edges_file, const char *delta_file,
+				 const layout_options &options );
+	drl_layout ( const drl_layout &loaded, const layout_options &options );
+	~drl_layout ( );
+
+private:
+
+	void init ( const layout_options &options );
+
+	// (copying a layout is not supported)
+	drl_layout ( const drl_layout & );
+	drl_layout &operator= ( const drl_layout & );
+
+	graph *engine;
+	layout_callback callback;
+	void *user_data;
+	std::atomic<bool> stop;
+};
+
+#endif
@@ -0,0 +1,635 @@
+// Multilevel
+//
+// This program runs the recursive version of DrL in a single process.
+// recursive_layout.sh runs truncate, layout, average_link, coarsen,
+// refine and recoord as separate programs, which pass every level
+// through .full, .int, .icoord, .iedges, .clust and .real files.  Here
+// the stages are called directly and each level is kept in memory.
+// The stages take the same inputs and .parms files as the programs, so
+// the levels are those of the script, except that graph weights and
+// coordinates are no longer rounded to text between programs.
+//
+// The files of each level can still be written (-w), so that a run
+// can be restarted from a given level (-r), as with the script.
+//
+// The structure of the inputs and outputs of this code will be displayed
+// if the program is called without parameters, or if an erroneous
+// parameter is passed to the program.
+
+// C++ library routines
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// layout routines and constants
+#include <graph.h>
+#include <multilevel.h>
+#include <multilevel_parse.h>
+#include <truncate_core.h>
+#include <average_link_core.h>
+#include <coarsen_core.h>
+#include <refine_core.h>
+#include <TextReader.h>
+
+// MPI
+#ifdef MUSE_MPI
+  #include <mpi.h>
+#endif
+
+// root name of the files of a level (as used by recursive_layout.sh)
+
+string level_name ( string root_file, int level_num )
+{
+  if ( level_num == 1 )
+    return root_file;
+
+  ostringstream name;
+  name << root_file << "_" << level_num;
+  return name.str();
+}
+
+// truncate_sim does the work of truncate (with the functions of the
+// truncate program): it reads the .sim file, numbers the ids in
+// alphabetical order (names holds the .ind file), and makes the .full
+// graph and the .int graph of the top links of each node.
+
+void truncate_sim ( parse &command_line, vector<string> &names, level &first )
+{
+  IdCatalog id_catalog;
+  vector<SimChunk> chunks;
+  vector<string_view> ids;
+  catalog_sim ( command_line.sim_file, command_line.num_threads, id_catalog, chunks, ids );
+  names.assign ( ids.begin(), ids.end() );
+
+  // (the rows of the .full graph are sorted as truncate sorts them,
+  // in runs on disk if there are too many)
+  EdgeRuns rows;
+  rows.Start ( command_line.root_file + ".int.run",
+               SORT_RUN_EDGES / command_line.memory_use );
+  EdgeWriter full;
+  full.Open ( &first.full );
+  translate_sim ( command_line.sim_file, command_line.num_threads, id_catalog, chunks,
+                  full, rows );
+  full.Close ();
+  rows.Finish ();
+
+  vector<float> denom_sims ( ids.size(), 1.0 );
+  if ( command_line.init_norm )
+    get_denoms ( rows, denom_sims );
+
+  EdgeWriter coarse_int;
+  coarse_int.Open ( &first.coarse_int );
+  truncate_rows ( rows, coarse_int, command_line.truncate_links, command_line.num_threads,
+                  denom_sims );
+  coarse_int.Close ();
+  rows.Remove ();
+}
+
+// cluster_level does the work of average_link (with the functions of
+// the average_link program): it clusters the layout of a level using
+// the edges left by layout and the shortest .full links of each node,
+// and sets the cluster of each node.
+
+void cluster_level ( level &fine, int num_short_links, int neighborhood_size )
+{
+
+  cout << "Clustering layout ..." << endl;
+
+  // average_link numbers nodes (pids) in the alphabetical order of
+  // their ids, so the nodes are numbered the same way here
+  vector<Node> &coord = fine.coord;
+  int num_coords = coord.size();
+  vector< pair<string, int> > by_name ( num_coords );
+  int max_id = -1;
+  for ( int i = 0; i < num_coords; i++ )
+  {
+    by_name[i] = make_pair ( to_string ( coord[i].id ), i );
+    max_id = max ( max_id, coord[i].id );
+  }
+  sort ( by_name.begin(), by_name.end() );
+
+  vector<int> pid ( max_id+1, -1 ), pid_id ( num_coords );
+  vector<float> x ( num_coords ), y ( num_coords );
+  for ( int p = 0; p < num_coords; p++ )
+  {
+    int i = by_name[p].second;
+    pid[coord[i].id] = p;
+    pid_id[p] = coord[i].id;
+    x[p] = coord[i].x;
+    y[p] = coord[i].y;
+  }
+  by_name.clear ();
+
+  // the edges left by layout, then the shortest .full links
+  ClusterGraph graph ( x, y, num_short_links );
+  for ( int pass = 0; pass < 2; pass++ )
+  {
+    vector<EdgeRecord> &edges = ( pass == 0 ) ? fine.edges : fine.full;
+    for ( unsigned long i = 0; i < edges.size(); i++ )
+    {
+      const EdgeRecord &edge = edges[i];
+      if ( edge.weight <= 0 )
+        continue;
+      if ( (edge.id1 < 0) || (edge.id1 > max_id) || (pid[edge.id1] < 0) ||
+           (edge.id2 < 0) || (edge.id2 > max_id) || (pid[edge.id2] < 0) )
+      {
+        cout << "Error: found identifiers not present in layout.  Program Stopped." << endl;
+        exit(1);
+      }
+      if ( pass == 0 )
+        graph.Add_Edge ( pid[edge.id1], pid[edge.id2] );
+      else
+        graph.Add_Link ( pid[edge.id1], pid[edge.id2] );
+    }
+    if ( pass == 0 )
+      graph.Sort_Edges ();
+  }
+  cout << "Total of " << graph.Merge_Links () << " edges in graph." << endl;
+
+  float threshold = select_threshold ( graph.min_sim, neighborhood_size );
+
+  // average link clustering
+  average_link cluster ( num_coords-1, threshold );
+  graph.Cluster ( cluster );
+
+  vector<int> clusters, importances;
+  cluster.get_clusters ( clusters, importances );
+  fine.cluster.assign ( max_id+1, 0 );
+  fine.importance.assign ( max_id+1, 0 );
+  for ( int p = 0; p < num_coords; p++ )
+  {
+    fine.cluster[pid_id[p]] = clusters[p];
+    fine.importance[pid_id[p]] = importances[p];
+  }
+}
+
+// coarsen_level does the work of coarsen (with the functions of the
+// coarsen program): the nodes of the fine level are merged by cluster
+// to give the .full graph of the coarse level, and its .int graph of
+// the top links of each cluster.
+
+void coarsen_level ( parse &command_line, level &fine, level &coarse )
+{
+
+  // cluster of each node (nodes without a cluster fall in cluster 0,
+  // as in coarsen) and the size of each cluster
+  int num_nodes = fine.cluster.size();
+  int num_clusts = 0;
+  vector<int> membership ( num_nodes, 0 );
+  for ( int i = 0; i < num_nodes; i++ )
+    if ( fine.cluster[i] > 0 )
+    {
+      membership[i] = fine.cluster[i]-1;
+      num_clusts = max ( num_clusts, fine.cluster[i] );
+    }
+  vector<int> sizes ( num_clusts, 0 );
+  for ( int i = 0; i < num_nodes; i++ )
+    if ( fine.cluster[i] > 0 )
+      sizes[fine.cluster[i]-1]++;
+
+  int min_clust, max_clust;
+  check_clusters ( sizes, num_clusts, min_clust, max_clust );
+
+  EdgeFile full;
+  full.Open ( fine.full );
+  vector<float> denom_sims ( num_clusts, 1.0 );
+  if ( command_line.normalize )
+    get_denoms ( full, command_line.memory_use, num_nodes, num_clusts, membership,
+                 denom_sims );
+
+  int topn_links[2] = { COARSE_LINKS_MIN, COARSE_LINKS_MAX };
+  EdgeWriter coarse_full, coarse_int;
+  coarse_full.Open ( &coarse.full );
+  coarse_int.Open ( &coarse.coarse_int );
+  coarsen_full ( full, coarse_full, coarse_int, command_line.memory_use, num_clusts,
+                 sizes, min_clust, max_clust, topn_links, membership, denom_sims,
+                 command_line.num_threads );
+  full.Close ();
+  coarse_full.Close ();
+  coarse_int.Close ();
+}
+
+// refine_level does the work of refine -r (with the functions of the
+// refine program): each node of the fine level is placed at the
+// (scaled) position of its cluster in the coarse layout, and the fine
+// .coarse_int graph is cut down to the nodes which were placed.
+
+void refine_level ( level &coarse, level &fine, float scale,
+                    vector<Node> &real, vector<EdgeRecord> &refine_int )
+{
+  int num_clusts = 0;
+  vector< pair<int, int> > cluster_ids;
+  for ( unsigned int i = 0; i < fine.cluster.size(); i++ )
+    if ( fine.cluster[i] > 0 )
+    {
+      cluster_ids.push_back ( make_pair ( fine.cluster[i]-1, (int)i ) );
+      num_clusts = max ( num_clusts, fine.cluster[i] );
+    }
+  cluster_list clusters;
+  list_clusters ( cluster_ids, num_clusts, clusters );
+
+  float x_scale = 1, y_scale = 1;
+  if ( scale > 0.0 )
+    get_scales ( coarse.coord, x_scale, y_scale );
+
+  cout << "Creating .real coordinates ..." << endl;
+  vector<char> placed;
+  place_nodes ( coarse.coord, clusters, scale, x_scale, y_scale, real, placed );
+
+  cout << "Converting .coarse_int graph ..." << endl;
+  EdgeFile coarse_int;
+  EdgeWriter refine_out;
+  coarse_int.Open ( fine.coarse_int );
+  refine_int.clear ();
+  refine_out.Open ( &refine_int );
+  refine_edges ( coarse_int, refine_out, placed );
+  coarse_int.Close ();
+  refine_out.Close ();
+}
+
+// layout_level does the work of layout -p -e -c edge_cut: it lays out
+// the .int graph, starting from the .real coordinates if any are given
+// (layout -r 0), and returns the .icoord layout and .iedges graph.
+
+void layout_level ( vector<EdgeRecord> &int_edges, vector<Node> &real, string parms_file,
+                    float edge_cut, int num_threads, string name, level &out )
+{
+  cout << "Laying out " << name << " ..." << endl;
+
+  graph neighbors ( 0, 1, int_edges );
+  neighbors.read_parms ( parms_file.c_str() );
+  neighbors.init_parms ( 0, edge_cut, real.empty() ? -1.0 : 0.0 );
+  neighbors.init_engine ( num_threads, 1 );
+  neighbors.init_grid ( 0 );
+  if ( !real.empty() )
+    neighbors.set_real ( real );
+
+  // (no intermediate output, so the .icoord name is not used)
+  char coord_file[MAX_FILE_NAME];
+  strncpy ( coord_file, (name + ".icoord").c_str(), MAX_FILE_NAME-1 );
+  coord_file[MAX_FILE_NAME-1] = 0;
+  neighbors.draw_graph ( 0, coord_file );
+
+  neighbors.get_sim ( out.edges );
+  neighbors.get_coord ( out.coord );
+  cout << "Total Energy: " << neighbors.get_tot_energy ( ) << "." << endl;
+}
+
+// The following routines write and read the files of a level, in
+// the formats used by the recursive layout programs.
+
+void write_edges ( string file_name, vector<EdgeRecord> &edges )
+{
+  EdgeWriter out;
+  if ( !out.Open ( file_name.c_str(), false ) )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  for ( unsigned long i = 0; i < edges.size(); i++ )
+    out.Write ( edges[i].id1, edges[i].id2, edges[i].weight );
+  if ( !out.Close() )
+  {
+    cout << "Error: could not write " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+}
+
+void read_edges ( string file_name, vector<EdgeRecord> &edges )
+{
+  cout << "Reading " << file_name << " ..." << endl;
+
+  EdgeFile in;
+  if ( !in.Open ( file_name.c_str() ) )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  EdgeRecord edge;
+  int id1, id2;
+  edges.clear ();
+  while ( in.Next ( id1, id2, edge.weight ) )
+  {
+    edge.id1 = id1;
+    edge.id2 = id2;
+    edges.push_back ( edge );
+  }
+  in.Close();
+}
+
+void write_coord ( string file_name, vector<Node> &coord )
+{
+  ofstream out ( file_name.c_str() );
+  if ( !out )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  for ( unsigned int i = 0; i < coord.size(); i++ )
+    out << coord[i].id << "\t" << coord[i].x << "\t" << coord[i].y << endl;
+  out.close();
+}
+
+void read_coord ( string file_name, vector<Node> &coord )
+{
+  cout << "Reading " << file_name << " ..." << endl;
+
+  TextReader in;
+  if ( !in.Open ( file_name.c_str() ) )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  int id;
+  float x, y;
+  coord.clear ();
+  while ( in.Read_Int ( id ) && in.Read_Float ( x ) && in.Read_Float ( y ) )
+  {
+    coord.push_back ( Node ( id ) );
+    coord.back().x = x;
+    coord.back().y = y;
+  }
+  in.Close();
+}
+
+void write_clust ( string file_name, level &fine )
+{
+  ofstream out ( file_name.c_str() );
+  if ( !out )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  for ( unsigned int i = 0; i < fine.cluster.size(); i++ )
+    if ( fine.cluster[i] != 0 )
+      out << i << "\t" << fine.cluster[i] << "\t" << fine.importance[i] << endl;
+  out.close();
+}
+
+void read_clust ( string file_name, level &fine )
+{
+  cout << "Reading " << file_name << " ..." << endl;
+
+  TextReader in;
+  if ( !in.Open ( file_name.c_str() ) )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  int int_id, clust_id, importance;
+  fine.cluster.clear ();
+  fine.importance.clear ();
+  while ( in.Read_Int ( int_id ) && in.Read_Int ( clust_id ) && in.Read_Int ( importance ) )
+  {
+    if ( int_id < 0 )
+    {
+      cout << "Error: found negative id in " << file_name << ".  Program terminated." << endl;
+      exit(1);
+    }
+    if ( int_id >= (int)fine.cluster.size() )
+    {
+      fine.cluster.resize ( int_id+1, 0 );
+      fine.importance.resize ( int_id+1, 0 );
+    }
+    fine.cluster[int_id] = clust_id;
+    fine.importance[int_id] = importance;
+  }
+  in.Close();
+}
+
+void write_ind ( string file_name, vector<string> &names )
+{
+  ofstream out ( file_name.c_str() );
+  if ( !out )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  for ( unsigned int i = 0; i < names.size(); i++ )
+    out << names[i] << "\t" << i << endl;
+  out.close();
+}
+
+void read_ind ( string file_name, vector<string> &names )
+{
+  cout << "Reading " << file_name << " ..." << endl;
+
+  // (string ids are tab delimited and may contain spaces)
+  TextReader in;
+  if ( !in.Open ( file_name.c_str() ) )
+  {
+    cout << "Error: could not open " << file_name << ".  Program terminated." << endl;
+    exit(1);
+  }
+  string name;
+  int int_id;
+  names.clear ();
+  while ( in.Read_Field ( name ) && in.Read_Int ( int_id ) )
+  {
+    if ( int_id < 0 )
+    {
+      cout << "Error: found negative id in " << file_name << ".  Program terminated." << endl;
+      exit(1);
+    }
+    if ( int_id >= (int)names.size() )
+      names.resize ( int_id+1 );
+    names[int_id] = name;
+  }
+  in.Close();
+}
+
+// write_results does the work of recoord: the final layout and edges
+// are written out with the original ids.
+
+void write_results ( parse &command_line, vector<string> &names, level &first )
+{
+  cout << "Creating .coord file ..." << endl;
+
+  ofstream out_coord ( command_line.coord_file.c_str() );
+  if ( !out_coord )
+  {
+    cout << "Error: could not open " << command_line.coord_file << "." << endl;
+    exit(1);
+  }
+  for ( unsigned int i = 0; i < first.coord.size(); i++ )
+  {
+    int int_id = first.coord[i].id;
+    if ( (int_id < 0) || (int_id >= (int)names.size()) )
+    {
+      cout << "Error: found unknown integer id." << endl;
+      exit(1);
+    }
+    out_coord << names[int_id] << "\t" << first.coord[i].x << "\t"
+              << first.coord[i].y << endl;
+  }
+  out_coord.close();
+
+  if ( !command_line.edges_out )
+    return;
+
+  cout << "Creating .edges file ..." << endl;
+
+  ofstream out_edges ( command_line.edges_file.c_str() );
+  if ( !out_edges )
+  {
+    cout << "Error: could not open " << command_line.edges_file << "." << endl;
+    exit(1);
+  }
+  for ( unsigned long i = 0; i < first.edges.size(); i++ )
+  {
+    int int_id1 = first.edges[i].id1;
+    int int_id2 = first.edges[i].id2;
+    if ( (int_id1 < 0) || (int_id1 >= (int)names.size()) ||
+         (int_id2 < 0) || (int_id2 >= (int)names.size()) )
+    {
+      cout << "Error: found unknown integer ids." << endl;
+      exit(1);
+    }
+    out_edges << names[int_id1] << "\t" << names[int_id2] << "\t"
+              << first.edges[i].weight << endl;
+  }
+  out_edges.close();
+}
+
+int main(int argc, char **argv)
+{
+
+  // the stages run on a single process (layout can use threads)
+  #ifdef MUSE_MPI
+    int num_procs;
+    MPI_Init ( &argc, &argv );
+    MPI_Comm_size ( MPI_COMM_WORLD, &num_procs );
+    if ( num_procs > 1 )
+    {
+      cout << "Error: multilevel runs on one process (use -p for threads)." << endl;
+      MPI_Abort ( MPI_COMM_WORLD, 1 );
+    }
+  #endif
+
+  // get user input
+  parse command_line ( argc, argv );
+  string root = command_line.root_file;
+  bool write = command_line.level_files;
+  int max_level = command_line.max_level;
+  int start_level = command_line.start_level;
+
+  vector<level> levels ( max_level+1 );
+  vector<string> names;
+  vector<Node> no_real;
+
+  if ( start_level == 1 )
+  {
+    // truncate the original dataset and make the first layout
+    cout << "----- INITIAL TRUNCATION -----" << endl;
+    truncate_sim ( command_line, names, levels[1] );
+    if ( write )
+    {
+      write_ind ( root + ".ind", names );
+      write_edges ( root + ".full", levels[1].full );
+      write_edges ( root + ".coarse_int", levels[1].coarse_int );
+    }
+
+    cout << "----- INITIAL LAYOUT -----" << endl;
+    layout_level ( levels[1].coarse_int, no_real, command_line.coarsen_parms,
+                   command_line.init_cut, command_line.num_threads, root, levels[1] );
+    if ( write )
+    {
+      write_coord ( root + ".coarse_icoord", levels[1].coord );
+      write_edges ( root + ".coarse_iedges", levels[1].edges );
+    }
+  }
+  else
+  {
+    // recover the levels below the restart level
+    cout << "----- RESTARTING AT LEVEL " << start_level << " -----" << endl;
+    read_ind ( root + ".ind", names );
+    for ( int l = 1; l < start_level-1; l++ )
+    {
+      read_clust ( level_name ( root, l ) + ".clust", levels[l] );
+      read_edges ( level_name ( root, l ) + ".coarse_int", levels[l].coarse_int );
+    }
+    string last = level_name ( root, start_level-1 );
+    read_edges ( last + ".full", levels[start_level-1].full );
+    read_edges ( last + ".coarse_int", levels[start_level-1].coarse_int );
+    read_coord ( last + ".coarse_icoord", levels[start_level-1].coord );
+    read_edges ( last + ".coarse_iedges", levels[start_level-1].edges );
+  }
+
+  // coarsen until the coarsest level is reached
+  for ( int l = max ( start_level, 2 ); l <= max_level; l++ )
+  {
+    cout << "----- COARSENING AT LEVEL " << l << " -----" << endl;
+
+    level &fine = levels[l-1];
+    level &coarse = levels[l];
+    string name = level_name ( root, l );
+
+    cluster_level ( fine, SHORT_LINKS, NEIGHBORHOOD_SIZE );
+    if ( write )
+      write_clust ( level_name ( root, l-1 ) + ".clust", fine );
+
+    coarsen_level ( command_line, fine, coarse );
+    if ( write )
+    {
+      write_edges ( name + ".full", coarse.full );
+      write_edges ( name + ".coarse_int", coarse.coarse_int );
+    }
+
+    // the fine level only needs its clusters and .coarse_int from now on
+    vector<EdgeRecord> ().swap ( fine.full );
+    vector<EdgeRecord> ().swap ( fine.edges );
+    vector<Node> ().swap ( fine.coord );
+
+    if ( l == max_level )
+      layout_level ( coarse.coarse_int, no_real, command_line.coarsest_parms,
+                     command_line.last_cut, command_line.num_threads, name, coarse );
+    else
+      layout_level ( coarse.coarse_int, no_real, command_line.coarsen_parms,
+                     command_line.coarse_cut, command_line.num_threads, name, coarse );
+    if ( write )
+    {
+      write_coord ( name + ".coarse_icoord", coarse.coord );
+      write_edges ( name + ".coarse_iedges", coarse.edges );
+    }
+  }
+
+  // now refine until the original level is reached
+  vector<Node> real;
+  vector<EdgeRecord> refine_int;
+  for ( int l = max_level; l > 1; l-- )
+  {
+    cout << "----- REFINING AT LEVEL " << l << " -----" << endl;
+
+    level &coarse = levels[l];
+    level &fine = levels[l-1];
+
+    refine_level ( coarse, fine, command_line.scale, real, refine_int );
+    levels[l] = level ();
+
+    if ( l-1 == 1 )
+      layout_level ( refine_int, real, command_line.final_parms,
+                     command_line.final_cut, command_line.num_threads, root, fine );
+    else
+      layout_level ( refine_int, real, command_line.refine_parms,
+                     command_line.refine_cut, command_line.num_threads,
+                     level_name ( root, l-1 ), fine );
+  }
+
+  // finally convert back to the original ids
+  write_results ( command_line, names, levels[1] );
+
+  cout << "Program finished successfully." << endl;
+
+  #ifdef MUSE_MPI
+    MPI_Finalize ();
+  #endif
+}
@@ -0,0 +1,36 @@
+// This file contains the structures of the multilevel program, which
+// does the work of the recursive layout programs (truncate,
+// average_link, coarsen, refine) with their core functions, on graphs
+// held in memory instead of files.
+
+#ifndef MULTILEVELH
+#define MULTILEVELH
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include <EdgeFile.h>
+#include <Node.h>
+
+// defaults of the programs called by recursive_layout.sh
+#define COARSE_LINKS_MIN 5		// coarsen -t (links kept for the smallest
+#define COARSE_LINKS_MAX 15		// and largest clusters)
+#define SHORT_LINKS 1			// average_link -s
+#define NEIGHBORHOOD_SIZE 10	// average_link -n
+
+// The level structure holds what recursive_layout.sh keeps in the
+// files of one level, in the integer ids of that level.
+
+struct level {
+	vector<EdgeRecord> full;		// .full graph
+	vector<EdgeRecord> coarse_int;	// .coarse_int graph (truncated .full)
+	vector<Node> coord;				// .icoord layout
+	vector<EdgeRecord> edges;		// .iedges graph left by edge cutting
+	vector<int> cluster;			// .clust cluster of each node, from 1
+									// (0 for nodes which were not clustered)
+	vector<int> importance;			// .clust importance of each node
+};
+
+#endif
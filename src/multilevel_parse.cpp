@@ -0,0 +1,248 @@
+// This file contains the methods for the parse.h class
+
+#include <string>
+#include <iostream>
+#include <cstdlib>
+
+using namespace std;
+
+// (VERSION and MAX_THREADS are those of layout)
+#include <layout.h>
+#include <multilevel_parse.h>
+
+void parse::print_syntax( const char *error_string )
+{
+  cout << endl << "Error: " << error_string << endl;
+  cout << endl << "Multilevel Layout" << endl
+	   <<     "-----------------" << endl
+	   << "Version " << VERSION << endl << endl
+	   << "This program runs the recursive version of DrL (the steps of" << endl
+	   << "recursive_layout.sh: truncate, layout, average_link, coarsen," << endl
+	   << "refine and recoord) in a single process, passing the graphs," << endl
+	   << "coordinates and clusters of each level in memory." << endl << endl
+	   << "Usage: openord_multilevel [options] root_file" << endl << endl
+	   << "root_file -- the root name of the files to be input and output." << endl << endl
+	   << "INPUT FILES:" << endl << endl
+	   << "root_file.sim contains the similarity graph, one edge per line" << endl
+	   << "\tid <tab> id <tab> weight" << endl
+	   << "  as read by truncate." << endl << endl
+	   << "coarsen.parms, coarsest.parms, refine.parms and final.parms are" << endl
+	   << "  the layout parameters used while coarsening, for the coarsest" << endl
+	   << "  layout, while refining and for the final layout.  They are read" << endl
+	   << "  from the directory containing root_file." << endl << endl
+	   << "OUTPUT FILES:" << endl << endl
+	   << "root_file.coord contains the final layout" << endl
+	   << "\tid <tab> x-coord <tab> y-coord" << endl << endl
+	   << "root_file.edges contains the edges left after edge cutting (-e)." << endl << endl
+	   << "OPTIONS:" << endl << endl
+	   << "\t-t {int>=1} number of links kept by truncate (default 10)" << endl
+	   << "\t-n normalize during truncation" << endl
+	   << "\t-u do not normalize during coarsening" << endl
+	   << "\t-l {int>=1} coarsest level (default 2)" << endl
+	   << "\t-r {int>=2} restart at level r, from the level files written" << endl
+	   << "\t            by -w (or by recursive_layout.sh)" << endl
+	   << "\t-c {real[0,1]} x 5 edge cutting for the initial, coarsening," << endl
+	   << "\t            coarsest, refining and final layouts" << endl
+	   << "\t            (default 1 1 .8 .5 .5)" << endl
+	   << "\t-s {real>0} scale coarse layouts up by s when refining" << endl
+	   << "\t            (default 450)" << endl
+	   << "\t-m {int>=1} divide the memory used by truncate and coarsen by m" << endl
+	   << "\t            (truncate sorts graphs of more than SORT_RUN_EDGES/m" << endl
+	   << "\t            edges in runs on disk, in temporary files" << endl
+	   << "\t            root_file.int.run0, root_file.int.run1, ..., and" << endl
+	   << "\t            coarsen builds each level in m passes)" << endl
+	   << "\t-p {int>=1} number of threads for truncate, coarsen and layout" << endl
+	   << "\t            (default 1)" << endl
+	   << "\t-e output .edges file" << endl
+	   << "\t-w write the .ind, .full, .coarse_int, .clust, .coarse_icoord" << endl
+	   << "\t   and .coarse_iedges files of each level (for -r)" << endl << endl;
+
+  exit(1);
+}
+
+parse::parse ( int argc, char** argv)
+{
+
+  // make sure there is at least one argument
+  if ( argc < 2)
+	print_syntax ( "not enough arguments!" );
+
+  // all input/output files use same root
+  root_file = sim_file = coord_file = edges_file = argv[argc-1];
+  sim_file = sim_file + ".sim";
+  coord_file = coord_file + ".coord";
+  edges_file = edges_file + ".edges";
+
+  // .parms files are kept with the data
+  string parms_dir;
+  size_t slash = root_file.find_last_of ( '/' );
+  if ( slash != string::npos )
+    parms_dir = root_file.substr ( 0, slash+1 );
+  coarsen_parms = parms_dir + "coarsen.parms";
+  coarsest_parms = parms_dir + "coarsest.parms";
+  refine_parms = parms_dir + "refine.parms";
+  final_parms = parms_dir + "final.parms";
+
+  // set defaults (as in recursive_layout.sh)
+  truncate_links = 10;
+  init_norm = false;
+  normalize = true;
+  start_level = 1;
+  max_level = 2;
+  init_cut = 1;
+  coarse_cut = 1;
+  last_cut = .8;
+  refine_cut = .5;
+  final_cut = .5;
+  scale = 450;
+  memory_use = 1;
+  num_threads = 1;
+  edges_out = false;
+  level_files = false;
+
+  // now check for optional arguments
+  string arg;
+  for( int i = 1; i<argc-1; i++ )
+  {
+	arg = argv[i];
+
+	// check for truncation links
+    if ( arg == "-t" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-t flag has no argument." );
+		else
+		{
+			truncate_links = atoi ( argv[i] );
+			if ( truncate_links <= 0 )
+				print_syntax ( "number of sim links must be >= 1." );
+		}
+	}
+
+	// check for coarsest level
+	else if ( arg == "-l" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-l flag has no argument." );
+		else
+		{
+			max_level = atoi ( argv[i] );
+			if ( max_level < 1 )
+				print_syntax ( "coarsest level must be >= 1." );
+		}
+	}
+
+	// check for restart level
+	else if ( arg == "-r" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-r flag has no argument." );
+		else
+		{
+			start_level = atoi ( argv[i] );
+			if ( start_level < 2 )
+				print_syntax ( "restart level must be >= 2." );
+		}
+	}
+
+	// check for edge cutting
+	else if ( arg == "-c" )
+	{
+		if ( i+5 >= (argc-1) )
+			print_syntax ( "-c flag needs five arguments." );
+		float *cuts[5] = { &init_cut, &coarse_cut, &last_cut, &refine_cut, &final_cut };
+		for ( int j = 0; j < 5; j++ )
+		{
+			i++;
+			*cuts[j] = atof ( argv[i] );
+			if ( (*cuts[j] < 0) || (*cuts[j] > 1) )
+				print_syntax ( "edge cut must be between 0 and 1." );
+		}
+	}
+
+	// check for scale
+	else if ( arg == "-s" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-s flag has no argument." );
+		else
+		{
+			scale = atof ( argv[i] );
+			if ( scale <= 0.0 )
+				print_syntax ( "scale value must be positive." );
+		}
+	}
+
+	// check for memory use
+	else if ( arg == "-m" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-m flag has no argument." );
+		else
+		{
+			memory_use = atoi ( argv[i] );
+			if ( memory_use < 1 )
+				print_syntax ( "memory use must be >= 1." );
+		}
+	}
+
+	// check for threads
+	else if ( arg == "-p" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-p flag has no argument." );
+		else
+		{
+			num_threads = atoi ( argv[i] );
+			if ( (num_threads < 1) || (num_threads > MAX_THREADS) )
+				print_syntax ( "number of threads must be from 1 to MAX_THREADS." );
+		}
+	}
+
+	else if ( arg == "-n" )
+		init_norm = true;
+	else if ( arg == "-u" )
+		normalize = false;
+	else if ( arg == "-e" )
+		edges_out = true;
+	else if ( arg == "-w" )
+		level_files = true;
+    else
+        print_syntax ( "unrecongized option!" );
+  }
+
+  if ( start_level > max_level )
+    print_syntax ( "restart level is past the coarsest level." );
+
+  // echo files
+  if ( start_level == 1 )
+    cout << "Using " << sim_file << " for .sim file." << endl;
+  else
+    cout << "Restarting at level " << start_level << " from the files of level "
+         << start_level-1 << "." << endl;
+  cout << "Using " << coarsen_parms << ", " << coarsest_parms << "," << endl
+       << "      " << refine_parms << " and " << final_parms << " for .parms files." << endl
+       << "Will output " << coord_file << " for .coord file";
+  if ( edges_out )
+    cout << " and " << edges_file << " for .edges file";
+  cout << "." << endl;
+
+  // echo arguments input or default
+  cout << "Using truncate links = " << truncate_links << endl
+       << "      normalize truncation = " << init_norm << endl
+       << "      normalize coarsening = " << normalize << endl
+       << "      coarsest level = " << max_level << endl
+       << "      edge cutting = " << init_cut << " " << coarse_cut << " " << last_cut
+       << " " << refine_cut << " " << final_cut << endl
+       << "      scale = " << scale << endl
+       << "      memory = " << memory_use << endl
+       << "      threads = " << num_threads << endl
+       << "      write level files = " << level_files << endl;
+
+}
@@ -0,0 +1,49 @@
+// The parse class contains the methods necessary to parse
+// the command line, print help, and do error checking
+
+#ifndef PARSEH
+#define PARSEH
+
+class parse {
+
+public:
+
+    // Methods
+
+	parse ( int argc, char **argv );
+	~parse () {}
+
+	// user parameters
+	string root_file;		// root name of the project
+	string sim_file;		// .sim file (input)
+	string coord_file;		// .coord file (output)
+	string edges_file;		// .edges file (output)
+	string coarsen_parms;	// .parms files for each kind of layout
+	string coarsest_parms;
+	string refine_parms;
+	string final_parms;
+
+	int truncate_links;		// number of links kept by truncate, int >= 1
+	bool init_norm;			// true to normalize during truncation
+	bool normalize;			// true to normalize during coarsening
+	int start_level;		// level to (re)start at, int >= 1
+	int max_level;			// coarsest level, int >= 1
+	float init_cut;			// edge cutting for each kind of layout, real [0,1]
+	float coarse_cut;
+	float last_cut;
+	float refine_cut;
+	float final_cut;
+	float scale;			// scale coarse layouts up by this when refining
+	int memory_use;			// divide the memory used by truncate and coarsen
+							// by this, int >= 1
+	int num_threads;		// threads for truncate, coarsen and layout, int >= 1
+	bool edges_out;			// true to output .edges file
+	bool level_files;		// true to write the files of each level
+
+private:
+
+	void print_syntax ( const char *error_string );
+
+};
+
+#endif
@@ -30,7 +30,8 @@ void parse::print_syntax( const char *error_string )
 	   << "  should have the form" << endl
 	   << "\tnode_id <tab> node_id <tab> weight" << endl
 	   << "  where node_id's are integers in sequence starting from 0, and" << endl
-	   << "  weight is a float > 0." << endl << endl
+	   << "  weight is a float > 0.  The binary .int files written by truncate -b" << endl
+	   << "  and coarsen -b can also be used." << endl << endl
 	   << "OUTPUT" << endl
 	   << "------" << endl
 	   << "root_file.icoord -- the resulting output file, containing an ordination" << endl
@@ -45,7 +46,43 @@ void parse::print_syntax( const char *error_string )
 	   << "\t-r {real[0,1]} input coordinates from .real file" << endl
 	   << "\t   (hold fixed until fraction of optimization schedule reached)" << endl
 	   << "\t-i {int>=0} intermediate output interval (default 0: no output)" << endl
-	   << "\t-e output .iedges file (same prefix as .coord file)" << endl << endl;
+	   << "\t-e output .iedges file (same prefix as .coord file)" << endl
+	   << "\t-t {int>=1} number of threads for shared memory layout (default 1)" << endl
+	   << "\t   (cannot be combined with MPI)" << endl
+	   << "\t-b {int>=1} nodes moved by each MPI process between position" << endl
+	   << "\t   exchanges (default 1: same schedule as serial layout)" << endl
+	   << "\t-g {int>=0} density grid size in cells, up to MAX_GRID_SIZE" << endl
+	   << "\t   (default 0: chosen from number of nodes)" << endl
+	   << "\t-q {real>0} use a Barnes-Hut tree for repulsion instead of the" << endl
+	   << "\t   density grid, with the given opening angle (e.g. .5); -g then" << endl
+	   << "\t   sets the layout plane, up to MAX_TREE_GRID_SIZE" << endl
+	   << "\t-m output .prof file (same prefix as .coord file), with one line" << endl
+	   << "\t   of comma separated timings and counts per iteration" << endl
+	   << "\t-k {int>=0} write a .chk checkpoint file every k iterations, and" << endl
+	   << "\t   on SIGTERM (0: on SIGTERM only).  Under MPI each process writes" << endl
+	   << "\t   .chk.<process id>" << endl
+	   << "\t--resume resume the layout from the .chk file (the other options" << endl
+	   << "\t   must be as they were for the layout to go on unchanged)" << endl
+	   << "\t-u {prev_root} update the layout prev_root.icoord, whose cut graph" << endl
+	   << "\t   is prev_root.iedges (layout -e), with the changed edges in" << endl
+	   << "\t   root_file.delta.  Each line of the .delta file is" << endl
+	   << "\t\tnode_id <tab> node_id <tab> weight" << endl
+	   << "\t   with weights as in the .iedges file; weight 0 removes the edge." << endl
+	   << "\t   New nodes take the next node_id's in sequence." << endl
+	   << "\t   New nodes start at the centroid of their neighbors and only" << endl
+	   << "\t   nodes near the changes are moved, with a short schedule" << endl
+	   << "\t-n {int>=0} with -u, move nodes up to n edges from a change" << endl
+	   << "\t   (default 2)" << endl
+	   << "\t-a {real>0} adaptive schedule: end a stage early once the total" << endl
+	   << "\t   energy and mean node displacement, averaged over ADAPT_WINDOW" << endl
+	   << "\t   iterations, change by less than this fraction (e.g. .001) per" << endl
+	   << "\t   iteration.  Stages run at least stage.min_iterations (optional" << endl
+	   << "\t   .parms lines, default ADAPT_MIN_FRACTION of the stage) and at" << endl
+	   << "\t   most stage.iterations." << endl
+	   << "\t-x {real>0} active set: from the cool-down stage on, skip nodes" << endl
+	   << "\t   which, with all their neighbors, moved less than this distance" << endl
+	   << "\t   (e.g. .01) in the last iteration, but for at most ACTIVE_MAX_SKIP" << endl
+	   << "\t   iterations in a row" << endl << endl;
  
   #ifdef MUSE_MPI
     MPI_Abort ( MPI_COMM_WORLD, 1 );
@@ -63,11 +100,14 @@ parse::parse ( int argc, char** argv)
 	print_syntax ( "not enough arguments!" );
   
   // make sure coord_file ends in ".coord"
-  parms_file = real_file = sim_file = coord_file = argv[argc-1];
+  parms_file = real_file = sim_file = coord_file = profile_file = checkpoint_file = argv[argc-1];
   parms_file = parms_file + ".parms";
   real_file = real_file + ".real";
   sim_file = sim_file + ".int";
   coord_file = coord_file + ".icoord";
+  profile_file = profile_file + ".prof";
+  checkpoint_file = checkpoint_file + ".chk";
+  delta_file = sim_file.substr ( 0, sim_file.length()-4 ) + ".delta";
   
   char error_string[200];
   sprintf ( error_string, "%s %d %s", "root file name cannot be longer than", MAX_FILE_NAME-7,
@@ -84,8 +124,20 @@ parse::parse ( int argc, char** argv)
   edge_cut = 32.0/40.0;
   int_out = 0;
   edges_out = 0;
+  profile_out = 0;
   parms_in = 0;
   real_in = -1.0;
+  num_threads = 1;
+  block_size = 1;
+  grid_size = 0;
+  theta = 0.0;
+  checkpoint_out = 0;
+  checkpoint_interval = 0;
+  resume = 0;
+  update_in = 0;
+  update_hops = 2;
+  adapt_tol = 0.0;
+  active_threshold = 0.0;
 
   // now check for optional arguments
   string arg;
@@ -145,26 +197,185 @@ parse::parse ( int argc, char** argv)
 				print_syntax ( "real iteration fraction must be from 0 to 1." );
 		}
 	}
+	// check for threads
+	else if ( arg == "-t" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-t flag has no argument." );
+		else
+		{
+			num_threads = atoi ( argv[i] );
+			if ( (num_threads < 1) || (num_threads > MAX_THREADS) )
+				print_syntax ( "number of threads must be from 1 to MAX_THREADS." );
+		}
+	}
+	// check for MPI block size
+	else if ( arg == "-b" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-b flag has no argument." );
+		else
+		{
+			block_size = atoi ( argv[i] );
+			if ( block_size < 1 )
+				print_syntax ( "block size must be >= 1." );
+		}
+	}
+	// check for density grid size
+	else if ( arg == "-g" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-g flag has no argument." );
+		else
+		{
+			grid_size = atoi ( argv[i] );
+			if ( (grid_size < 0) || (grid_size > MAX_TREE_GRID_SIZE) )
+				print_syntax ( "grid size must be from 0 to MAX_TREE_GRID_SIZE." );
+			if ( (grid_size > 0) && (grid_size <= 4*RADIUS) )
+				print_syntax ( "grid size too small for density fall-off." );
+		}
+	}
+	// check for Barnes-Hut tree
+	else if ( arg == "-q" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-q flag has no argument." );
+		else
+		{
+			theta = atof ( argv[i] );
+			if ( theta <= 0 )
+				print_syntax ( "opening angle must be > 0." );
+		}
+	}
+	// check for checkpoints
+	else if ( arg == "-k" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-k flag has no argument." );
+		else
+		{
+			checkpoint_out = 1;
+			checkpoint_interval = atoi ( argv[i] );
+			if ( checkpoint_interval < 0 )
+				print_syntax ( "checkpoint interval must be >= 0." );
+		}
+	}
+	else if ( arg == "--resume" )
+		resume = 1;
+	// check for update of a previous layout
+	else if ( arg == "-u" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-u flag has no argument." );
+		else
+		{
+			update_in = 1;
+			update_coord_file = argv[i];
+			update_coord_file = update_coord_file + ".icoord";
+			update_edges_file = argv[i];
+			update_edges_file = update_edges_file + ".iedges";
+			if ( update_coord_file.length() > MAX_FILE_NAME )
+				print_syntax ( error_string );
+		}
+	}
+	// check for adaptive schedule
+	else if ( arg == "-a" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-a flag has no argument." );
+		else
+		{
+			adapt_tol = atof ( argv[i] );
+			if ( adapt_tol <= 0 )
+				print_syntax ( "adaptive tolerance must be > 0." );
+		}
+	}
+	// check for active set
+	else if ( arg == "-x" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-x flag has no argument." );
+		else
+		{
+			active_threshold = atof ( argv[i] );
+			if ( active_threshold <= 0 )
+				print_syntax ( "active set threshold must be > 0." );
+		}
+	}
+	else if ( arg == "-n" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-n flag has no argument." );
+		else
+		{
+			update_hops = atoi ( argv[i] );
+			if ( update_hops < 0 )
+				print_syntax ( "update neighborhood must be >= 0." );
+		}
+	}
 	else if ( arg == "-e" )
 		edges_out = 1;
 	else if ( arg == "-p" )
 		parms_in = 1;
+	else if ( arg == "-m" )
+		profile_out = 1;
 	else
 		print_syntax ( "unrecongized option!" );
   }
   
+  if ( update_in && (real_in >= 0) )
+	print_syntax ( "-u and -r cannot be used together." );
+	
+  // only the tree can use a plane larger than the density grid
+  if ( (theta <= 0) && (grid_size > MAX_GRID_SIZE) )
+	print_syntax ( "grid size must be from 0 to MAX_GRID_SIZE." );
+  
   if ( parms_in )
     cout << "Using " << parms_file << " for .parms file." << endl;
 	
   if ( real_in >= 0 )
     cout << "Using " << real_file << " for .real file." << endl;
 	
+  if ( profile_out )
+    cout << "Using " << profile_file << " for .prof file." << endl;
+	
+  if ( update_in )
+    cout << "Updating " << update_coord_file << " (graph " << update_edges_file
+	     << ") with " << delta_file << "." << endl;
+	
+  if ( checkpoint_out || resume )
+    cout << "Using " << checkpoint_file << " for .chk file." << endl;
+	
   // echo arguments input or default
   cout << "Using random seed = " << rand_seed << endl
        << "      edge_cutting = " << edge_cut << endl
        << "      intermediate output = " << int_out << endl
-       << "      output .iedges file = " << edges_out << endl;
+       << "      output .iedges file = " << edges_out << endl
+       << "      threads = " << num_threads << endl
+       << "      MPI block size = " << block_size << endl
+       << "      density grid size = " << grid_size << endl;
+  if ( theta > 0 )
+	cout << "      Barnes-Hut opening angle = " << theta << endl;
   if ( real_in >= 0 )
 	cout << "      holding .real fixed until iterations = " << real_in << endl;
+  if ( checkpoint_out )
+	cout << "      checkpoint interval = " << checkpoint_interval << endl;
+  if ( resume )
+	cout << "      resuming from .chk file" << endl;
+  if ( update_in )
+	cout << "      update neighborhood = " << update_hops << endl;
+  if ( adapt_tol > 0 )
+	cout << "      adaptive schedule tolerance = " << adapt_tol << endl;
+  if ( active_threshold > 0 )
+	cout << "      active set threshold = " << active_threshold << endl;
 
 }
@@ -19,13 +19,30 @@ public:
 	string coord_file;		// .coord file
 	string parms_file;		// .parms file
 	string real_file;	    // .real file
+	string profile_file;	// .prof file
+	string checkpoint_file;	// .chk file
+	string delta_file;		// .delta file
+	string update_coord_file;	// .icoord file of previous layout
+	string update_edges_file;	// .iedges file of previous layout
 	
 	int rand_seed;		// random seed int >= 0
 	float edge_cut;			// edge cutting real [0,1]
 	int int_out;			// intermediate output, int >= 1
 	int edges_out;                  // true if .edges file is requested
+	int profile_out;		// true if .prof file is requested
 	int parms_in;		    // true if .parms file is to be read
 	float real_in;		    // true if .real file is to be read
+	int num_threads;		// threads for shared memory layout, int >= 1
+	int block_size;			// nodes per proc between MPI exchanges, int >= 1
+	int grid_size;			// density grid size, int >= 0 (0 = automatic)
+	float theta;			// Barnes-Hut opening angle, real > 0 (0 = density grid)
+	int checkpoint_out;		// true if .chk file is to be written
+	int checkpoint_interval;	// iterations between checkpoints, int >= 0 (0 = on SIGTERM only)
+	int resume;				// true if layout is resumed from .chk file
+	int update_in;			// true if previous layout is to be updated
+	int update_hops;		// neighborhood of changes to update, int >= 0
+	float active_threshold;	// active set threshold, real > 0 (0 = move every node)
+	float adapt_tol;		// adaptive schedule tolerance, real > 0 (0 = fixed schedule)
 	
 private:
 
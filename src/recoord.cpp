@@ -24,14 +24,28 @@ using namespace std;
 
 // parse command line
 #include <recoord_parse.h>
+#include <TextReader.h>
+#include <StringTable.h>
+
+// The id catalog gives the string id of each integer id, as the
+// string_id[int_id]-th string of strings (-1 for an unknown id)
+
+struct IdCatalog {
+  StringTable strings;
+  vector<int> string_id;
+  
+  bool Has ( int int_id ) const
+    { return (int_id >= 0) && (int_id < (int)string_id.size()) && (string_id[int_id] >= 0); }
+  string_view operator[] ( int int_id ) const { return strings.String ( string_id[int_id] ); }
+};
 
 // create .edges file from .iedges file
-void create_edges ( map < int, string > &id_catalog, string iedges_file,
+void create_edges ( IdCatalog &id_catalog, string iedges_file,
 				    string edges_file )
 {
 
-  ifstream in_edges ( iedges_file.c_str() );
-  if ( !in_edges )
+  TextReader in_edges;
+  if ( !in_edges.Open ( iedges_file.c_str() ) )
   {
     cout << "Error: could not open " << iedges_file << "." << endl;
     exit(1);
@@ -50,16 +64,11 @@ void create_edges ( map < int, string > &id_catalog, string iedges_file,
   
   int int_id1, int_id2;
   float weight;
-  while ( !in_edges.eof() )
+  while ( in_edges.Read_Int ( int_id1 ) && in_edges.Read_Int ( int_id2 ) &&
+		  in_edges.Read_Float ( weight ) )
   {
   
-     int_id1 = -1;
-	 in_edges >> int_id1 >> int_id2 >> weight;
-	 
-	 if ( int_id1 >= 0 )	// not at end of file
-	 {
-	   if ( (id_catalog.find ( int_id1 ) == id_catalog.end()) ||
-	        (id_catalog.find ( int_id2 ) == id_catalog.end()) )
+	   if ( !id_catalog.Has ( int_id1 ) || !id_catalog.Has ( int_id2 ) )
 	   {
 		 cout << "Error: found unknown integer ids." << endl;
 		 exit (1);
@@ -67,22 +76,21 @@ void create_edges ( map < int, string > &id_catalog, string iedges_file,
 	   else
 	     out_edges << id_catalog[int_id1] << "\t" << id_catalog[int_id2] << "\t"
 			       << weight << endl;
-	 }
 	 
   }
   
-  in_edges.close();
+  in_edges.Close();
   out_edges.close();
   
 }
 
 // create .coord file from .icoord file
-void create_coord ( map < int, string > &id_catalog, string icoord_file,
+void create_coord ( IdCatalog &id_catalog, string icoord_file,
 				    string coord_file )
 {
 
-  ifstream in_coord ( icoord_file.c_str() );
-  if ( !in_coord )
+  TextReader in_coord;
+  if ( !in_coord.Open ( icoord_file.c_str() ) )
   {
     cout << "Error: could not open " << icoord_file << "." << endl;
     exit(1);
@@ -101,67 +109,62 @@ void create_coord ( map < int, string > &id_catalog, string icoord_file,
   
   int int_id;
   float x_coord, y_coord;
-  while ( !in_coord.eof() )
+  while ( in_coord.Read_Int ( int_id ) && in_coord.Read_Float ( x_coord ) &&
+		  in_coord.Read_Float ( y_coord ) )
   {
-  
-     int_id = -1;
-	 in_coord >> int_id >> x_coord >> y_coord;
-	 
-	 if ( int_id >= 0 )	// not at end of file
-	 {
-	   if ( id_catalog.find(int_id) != id_catalog.end() )
+	   if ( id_catalog.Has ( int_id ) )
 	     out_coord << id_catalog[int_id] << "\t" << x_coord << "\t" << y_coord << endl;
 	   else
 	   {
 	     cout << "Error: found unknown integer id." << endl;
 		 exit (1);
 	   }
-	 }
   }
   
-  in_coord.close();
+  in_coord.Close();
   out_coord.close();
   
 }
 
 // read .ind file into id_catalog variable
-void read_ind ( string ind_file, map < int, string > &id_catalog )
+void read_ind ( string ind_file, IdCatalog &id_catalog )
 {
 
   cout << "Reading .ind file ..." << endl;
   
   int int_id;
   string string_id;
-  char id_buf[200];
-  int ret;
-
-  // code to read .ind file was taken from original vxord
-  // Open File
-  FILE *fp;
-  fp = fopen(ind_file.c_str(),"r");
-  if (fp == NULL) {
+
+  // Open File (string ids are tab delimited and may contain spaces)
+  TextReader ind_in;
+  if ( !ind_in.Open ( ind_file.c_str() ) ) {
 		printf("Couldn't open input file %s.\n",ind_file.c_str());
 		exit(1);
   }
   
-  // Read in all coordinates
-  while ((ret=fscanf(fp,"%[^\t]\t%d\n",id_buf,&int_id)) && (ret!=EOF)) {
-		
-		// Convert id to string
-		string_id = id_buf;	
+  // Read in all ids
+  bool added;
+  while ( ind_in.Read_Field ( string_id ) && ind_in.Read_Int ( int_id ) ) {
 		
-		id_catalog[int_id] = string_id;
+		if ( int_id < 0 )
+		{
+			cout << "Error: found negative integer id in " << ind_file << "." << endl;
+			exit(1);
+		}
+		if ( int_id >= (int)id_catalog.string_id.size() )
+			id_catalog.string_id.resize ( int_id + 1, -1 );
+		id_catalog.string_id[int_id] = id_catalog.strings.Add ( string_id, added );
 		
   }
 
   // Close file
-  fclose(fp);
+  ind_in.Close();
 
   /*
   // print out id catalog (for debugging)
-  map < int, string >::iterator cat_iter;
-  for ( cat_iter = id_catalog.begin(); cat_iter != id_catalog.end(); cat_iter++ )
-    cout << cat_iter->first << "\t" << cat_iter->second << endl;
+  for ( int int_id = 0; int_id < (int)id_catalog.string_id.size(); int_id++ )
+    if ( id_catalog.Has ( int_id ) )
+      cout << int_id << "\t" << id_catalog[int_id] << endl;
   */
   	
 }
@@ -172,7 +175,7 @@ int main(int argc, char *argv[]) {
   parse command_line ( argc, argv );
   
   // read .ind file
-  map < int, string > id_catalog;
+  IdCatalog id_catalog;
   read_ind ( command_line.ind_file, id_catalog );
 
   // translate .icoord to .coord
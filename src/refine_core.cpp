@@ -0,0 +1,101 @@
+// This file contains the functions of refine_core.h
+
+// C++ library routines
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#include <refine_core.h>
+
+void list_clusters ( vector < pair<int, int> > &cluster_ids, int num_clusts,
+                     cluster_list &clusters )
+{
+  sort ( cluster_ids.begin(), cluster_ids.end() );
+  cluster_ids.erase ( unique ( cluster_ids.begin(), cluster_ids.end() ), cluster_ids.end() );
+
+  num_clusts = max ( num_clusts, 0 );
+  clusters.first.assign ( num_clusts+1, 0 );
+  clusters.members.clear ();
+  for ( unsigned long i = 0; i < cluster_ids.size(); i++ )
+    if ( (cluster_ids[i].first >= 0) && (cluster_ids[i].first < num_clusts) )
+    {
+      clusters.members.push_back ( cluster_ids[i].second );
+      clusters.first[cluster_ids[i].first+1] = clusters.members.size();
+    }
+
+  // (clusters without members end where the one before them does)
+  for ( int c = 1; c <= num_clusts; c++ )
+    clusters.first[c] = max ( clusters.first[c], clusters.first[c-1] );
+}
+
+void get_scales ( vector <Node> &coord, float &x_scale, float &y_scale )
+{
+  cout << "Finding max and min x and y values for scaling ..." << endl;
+
+  float max_x, max_y, min_x, min_y;
+  max_x = max_y = -1.0;
+  min_x = min_y = 1.0;
+  for ( unsigned int i = 0; i < coord.size(); i++ )
+  {
+    if ( coord[i].x > max_x ) max_x = coord[i].x;
+    if ( coord[i].x < min_x ) min_x = coord[i].x;
+    if ( coord[i].y > max_y ) max_y = coord[i].y;
+    if ( coord[i].y < min_y ) min_y = coord[i].y;
+  }
+
+  if ( max_x > -min_x ) x_scale = max_x; else x_scale = -min_x;
+  if ( max_y > -min_y ) y_scale = max_y; else y_scale = -min_y;
+
+  // preserve x/y aspect ratio
+  if ( x_scale > y_scale ) y_scale = x_scale; else x_scale = y_scale;
+
+  cout << "Using " << x_scale << " as scale factor." << endl;
+}
+
+void place_nodes ( vector <Node> &coord, cluster_list &clusters, float scale,
+                   float x_scale, float y_scale, vector <Node> &real,
+                   vector <char> &placed )
+{
+  int num_clusts = clusters.first.size() - 1;
+  int max_id = -1;
+  for ( unsigned long i = 0; i < clusters.members.size(); i++ )
+    max_id = max ( max_id, clusters.members[i] );
+  placed.assign ( max_id+1, 0 );
+
+  real.clear ();
+  for ( unsigned int i = 0; i < coord.size(); i++ )
+  {
+    int clust_id = coord[i].id;
+    if ( (clust_id < 0) || (clust_id >= num_clusts) )
+      continue;
+    for ( long j = clusters.first[clust_id]; j < clusters.first[clust_id+1]; j++ )
+    {
+      int int_id = clusters.members[j];
+      placed[int_id] = 1;
+      real.push_back ( Node ( int_id ) );
+      if ( scale > 0.0 )
+      {
+        real.back().x = coord[i].x*scale/x_scale;
+        real.back().y = coord[i].y*scale/y_scale;
+      }
+      else
+      {
+        real.back().x = coord[i].x;
+        real.back().y = coord[i].y;
+      }
+    }
+  }
+}
+
+void refine_edges ( EdgeFile &in, EdgeWriter &out, vector <char> &placed )
+{
+  int num_nodes = placed.size();
+  int id1, id2;
+  float edge_weight;
+  while ( in.Next ( id1, id2, edge_weight ) )
+    if ( (id1 >= 0) && (id1 < num_nodes) && placed[id1] &&
+         (id2 >= 0) && (id2 < num_nodes) && placed[id2] )
+      out.Write ( id1, id2, edge_weight );
+}
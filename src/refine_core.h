@@ -0,0 +1,43 @@
+// This file contains the core of refine, shared by the refine program
+// and openord_multilevel: each node of the fine level is placed at the
+// (scaled) position of its cluster in the coarse layout, and the fine
+// .coarse_int graph is cut down to the nodes which were placed.
+
+#ifndef REFINE_COREH
+#define REFINE_COREH
+
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+#include <EdgeFile.h>
+#include <Node.h>
+
+// The cluster_list structure holds the members of each cluster (from
+// 0) in increasing id: cluster c has members[first[c]] ...
+// members[first[c+1]-1].
+struct cluster_list {
+  vector<long> first;
+  vector<int> members;
+};
+
+// list_clusters lists the members of clusters 0 ... num_clusts-1 from
+// (cluster, id) pairs, a pair given twice counting once
+void list_clusters ( vector < pair<int, int> > &cluster_ids, int num_clusts,
+                     cluster_list &clusters );
+
+// get_scales finds the largest magnitude x and y values of a layout
+// (the same for both, to keep the aspect ratio)
+void get_scales ( vector <Node> &coord, float &x_scale, float &y_scale );
+
+// place_nodes puts the members of each cluster in coord (the coarse
+// layout, whose ids are clusters) into real, in the order of coord, and
+// marks them in placed (by id); refine_edges writes the edges of in
+// between placed nodes to out
+void place_nodes ( vector <Node> &coord, cluster_list &clusters, float scale,
+                   float x_scale, float y_scale, vector <Node> &real,
+                   vector <char> &placed );
+void refine_edges ( EdgeFile &in, EdgeWriter &out, vector <char> &placed );
+
+#endif
@@ -0,0 +1,290 @@
+// This file contains the functions of truncate_core.h
+
+// C++ library routines
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>
+
+using namespace std;
+
+#include <truncate_core.h>
+#include <TextReader.h>
+#include <TopLinks.h>
+
+void IdCatalog::Add ( string_view id )
+{
+  uint64_t hash = StringTable::Hash ( id );
+  Shard &shard = shards[Shard_Of ( hash )];
+  lock_guard<mutex> lock ( shard.lock );
+  bool added;
+  shard.ids.Add ( id, hash, added );
+  if ( added )
+    shard.numbers.push_back ( -1 );
+}
+
+// Number numbers the ids in sorted order, returned in ids (which
+// point into the catalog)
+
+void IdCatalog::Number ( vector<string_view> &ids )
+{
+  // (the shard and index of each id)
+  vector< pair<int, int> > kept;
+  for ( int s = 0; s < CATALOG_SHARDS; s++ )
+    for ( int index = 0; index < shards[s].ids.Size(); index++ )
+      kept.push_back ( pair<int, int> ( s, index ) );
+  
+  sort ( kept.begin(), kept.end(), [this]( const pair<int, int> &a, const pair<int, int> &b ) {
+    return shards[a.first].ids.String ( a.second ) < shards[b.first].ids.String ( b.second ); } );
+  
+  ids.resize ( kept.size() );
+  for ( unsigned int i = 0; i < kept.size(); i++ )
+  {
+    Shard &shard = shards[kept[i].first];
+    shard.numbers[kept[i].second] = i;
+    ids[i] = shard.ids.String ( kept[i].second );
+  }
+  size = kept.size();
+}
+
+// Find returns the number of an id, -1 if it is not in the catalog
+// (no lock is taken, so ids must not be added at the same time)
+
+int IdCatalog::Find ( string_view id ) const
+{
+  uint64_t hash = StringTable::Hash ( id );
+  const Shard &shard = shards[Shard_Of ( hash )];
+  int index = shard.ids.Find ( id, hash );
+  if ( index < 0 )
+    return -1;
+  return shard.numbers[index];
+}
+
+// split_sim cuts the .sim file into chunks of whole lines
+
+static void split_sim ( string sim_file, int num_threads, vector<SimChunk> &chunks )
+{
+  ifstream sim ( sim_file.c_str(), ios::binary );
+  if ( !sim )
+  {
+	cout << "Error: could not open " << sim_file << ".  Program terminated." << endl;
+	exit (1);
+  }
+  sim.seekg ( 0, ios::end );
+  long size = sim.tellg ();
+  long chunk_bytes = min ( SIM_CHUNK, size / num_threads + 1 );
+  
+  // each chunk ends after the first newline chunk_bytes on
+  for ( long offset = 0; offset < size; )
+  {
+    long end = offset + chunk_bytes;
+    if ( end >= size )
+      end = size;
+    else
+    {
+      sim.seekg ( end - 1 );
+      int c;
+      while ( ((c = sim.get()) != EOF) && (c != '\n') )
+        end++;
+      sim.clear ();
+    }
+    SimChunk chunk;
+    chunk.offset = offset;
+    chunk.length = end - offset;
+    chunk.lines = 0;
+    chunk.stopped = false;
+    chunks.push_back ( chunk );
+    offset = end;
+  }
+}
+
+// for_chunks runs work ( c ) for chunks first ... last-1, with
+// num_threads threads each taking the next chunk left
+
+static void for_chunks ( int first, int last, int num_threads, const function<void ( int )> &work )
+{
+  atomic<int> next ( first );
+  auto worker = [&]() {
+    for ( int c = next++; c < last; c = next++ )
+      work ( c );
+  };
+  
+  vector<thread> workers;
+  for ( int t = 1; t < min ( num_threads, last - first ); t++ )
+    workers.push_back ( thread ( worker ) );
+  worker ();
+  for ( unsigned int t = 0; t < workers.size(); t++ )
+    workers[t].join ();
+}
+
+
+// catalog_sim scans the .sim file and creates the id catalog, with
+// num_threads threads each reading a chunk of the file.
+
+void catalog_sim ( string sim_file, int num_threads, IdCatalog &id_catalog,
+                   vector<SimChunk> &chunks, vector<string_view> &ids )
+{
+
+  cout << "Reading .sim file ... " << endl;
+  
+  chunks.clear ();
+  split_sim ( sim_file, num_threads, chunks );
+  
+  // Read file, parse, and add ids to the catalog
+  for_chunks ( 0, chunks.size(), num_threads, [&]( int c ) {
+    SimChunk &chunk = chunks[c];
+    
+    // ids are tab delimited (and may contain spaces)
+    string id1, id2;
+    float edge_weight;
+    
+    TextReader sim;
+    if ( !sim.Open ( sim_file.c_str(), chunk.offset, chunk.length ) )
+    {
+	  cout << "Error: could not open " << sim_file << ".  Program terminated." << endl;
+	  exit (1);
+    }
+    while ( !sim.At_End () )
+    {
+      if ( !(sim.Read_Field ( id1 ) && sim.Read_Field ( id2 ) && sim.Read_Float ( edge_weight )) )
+      {
+        chunk.stopped = true;
+        break;
+      }
+      
+      // count line
+      chunk.lines++;
+      
+      // ignore negative weights!
+      if ( edge_weight > 0 )
+      {
+        id_catalog.Add ( id1 );
+        id_catalog.Add ( id2 );
+      }
+    }
+    sim.Close();
+  } );
+  
+  // the whole file must be read
+  long line_count = 0;
+  for ( unsigned int c = 0; c < chunks.size(); c++ )
+  {
+    line_count += chunks[c].lines;
+    if ( chunks[c].stopped )
+    {
+      cout << "Error: could not read " << sim_file << " after " << line_count
+           << " lines.  Program terminated." << endl;
+      exit (1);
+    }
+  }
+  
+  // node ids have been determined
+  id_catalog.Number ( ids );
+
+  if ( ids.size() == 0 )
+  {
+    cout << "Error: " << sim_file << " is empty.  Program terminated." << endl;
+	exit (1);
+  }
+  
+  cout << "Read " << ids.size() << " nodes and " << line_count << " lines." << endl;
+
+}
+
+// translate_sim reads the .sim file again and writes the .full graph,
+// which is the same as the .sim file but contains the integer ids of
+// the catalog.  The edges of the .full graph are also added to rows,
+// to be sorted.
+
+void translate_sim ( string sim_file, int num_threads, IdCatalog &id_catalog,
+                     vector<SimChunk> &chunks, EdgeWriter &full, EdgeRuns &rows )
+{
+  cout << "Writing to .full file ..." << endl;
+  
+  
+  // Read file again, num_threads chunks at a time, and output to .full
+  for ( int first = 0; first < (int)chunks.size(); first += num_threads )
+  {
+    int last = min ( first + num_threads, (int)chunks.size() );
+    for_chunks ( first, last, num_threads, [&]( int c ) {
+      SimChunk &chunk = chunks[c];
+      string id1, id2;
+      float edge_weight;
+      
+      TextReader sim;
+      if ( !sim.Open ( sim_file.c_str(), chunk.offset, chunk.length ) )
+      {
+	    cout << "Error: could not open " << sim_file << " (for translation to .int).  Program terminated." << endl;
+	    exit (1);
+      }
+      chunk.block.Clear ( full.Is_Binary() );
+      while ( sim.Read_Field ( id1 ) && sim.Read_Field ( id2 ) && sim.Read_Float ( edge_weight ) )
+        // ignore negative weights!
+        if ( edge_weight > 0 )
+          chunk.block.Write ( id_catalog.Find ( id1 ), id_catalog.Find ( id2 ), edge_weight );
+      sim.Close();
+    } );
+    
+    // output to .full, in order
+    for ( int c = first; c < last; c++ )
+    {
+      full.Write ( chunks[c].block );
+      const EdgeRecord *records = chunks[c].block.Records();
+      for ( long e = 0; e < chunks[c].block.Num_Edges(); e++ )
+        rows.Add ( records[e] );
+      chunks[c].block = EdgeBlock ();
+    }
+  }
+
+}
+
+// This routine uses the rows of the .full file to compute the
+// denominators for normalization
+
+void get_denoms ( EdgeRuns &rows, vector <float> &denom_sims )
+{
+  cout << "Computing normalization denominators ..." << endl;
+  vector<int> columns;
+  vector<float> weights;
+  int row;
+  
+  rows.Rewind ();
+  while ( rows.Next_Row ( row, columns, weights ) )
+  {
+    denom_sims[row] = 0.0;
+    for ( unsigned int k = 0; k < weights.size(); k++ )
+      denom_sims[row] = denom_sims[row] + weights[k];
+  }
+}
+
+// Next we create a precursor .int graph (normalized but not between 0 and 1)
+// from the top n links of each row, largest first (ties go to the
+// larger column).  Rows are gathered in batches, which are normalized
+// and cut to their top links by num_threads threads.
+
+void truncate_rows ( EdgeRuns &rows, EdgeWriter &out, int topn, int num_threads,
+                     vector <float> &denom_sims )
+{
+  cout << "Creating .int file ..." << endl;
+  vector<int> columns;
+  vector<float> weights;
+  int row;
+  
+  TopLinks batch;
+  rows.Rewind ();
+  while ( rows.Next_Row ( row, columns, weights ) )
+  {
+    // output top n in this row (normalized)
+    batch.Add_Row ( row, columns, weights, topn );
+    if ( batch.Num_Links() >= TOP_LINKS_BATCH )
+      batch.Write ( out, num_threads, &denom_sims );
+  }
+  batch.Write ( out, num_threads, &denom_sims );
+}
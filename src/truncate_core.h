@@ -0,0 +1,84 @@
+// This file contains the core of truncate, shared by the truncate
+// program and openord_multilevel: the .sim file is read into an id
+// catalog and a .full graph, whose rows (sorted by EdgeRuns) give the
+// .int graph of the top links of each node.
+
+#ifndef TRUNCATE_COREH
+#define TRUNCATE_COREH
+
+// edges sorted in memory at once (-m divides this); larger graphs are
+// sorted in runs on disk
+#define SORT_RUN_EDGES (1L << 24)
+
+// bytes of the .sim file read by a thread at a time, and the number of
+// separately locked parts of the id catalog
+#define SIM_CHUNK (1L << 26)
+#define CATALOG_SHARDS 256
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+#include <EdgeFile.h>
+#include <EdgeRuns.h>
+#include <StringTable.h>
+
+// The id catalog is split into CATALOG_SHARDS shards by the hash of the
+// id, each a StringTable with its own lock, so that several threads
+// reading the .sim file can add ids at once.  Once the file is read
+// Number numbers the ids in sorted order, and Find gives the number
+// of an id.
+
+class IdCatalog {
+
+public:
+
+	void Add ( string_view id );
+	void Number ( vector<string_view> &ids );
+	int Find ( string_view id ) const;
+	long Size ( ) const { return size; }
+
+	IdCatalog ( ) : size ( 0 ) { }
+
+private:
+
+	struct Shard {
+	  mutex lock;
+	  StringTable ids;
+	  vector<int> numbers;		// number of each id (once numbered)
+	};
+
+	// (the shard is picked by the high bits of the hash, the slot in
+	// its table by the low bits)
+	static int Shard_Of ( uint64_t hash ) { return (hash >> 40) % CATALOG_SHARDS; }
+
+	Shard shards[CATALOG_SHARDS];
+	long size;
+};
+
+// The .sim file is read in chunks of whole lines, num_threads chunks
+// at a time.  A chunk with a line that can't be read as id id weight
+// is marked stopped, and the .sim file is rejected.
+
+struct SimChunk {
+  long offset, length;			// bytes of the .sim file
+  long lines;					// lines read
+  bool stopped;					// true if a line couldn't be read
+  EdgeBlock block;				// the chunk's edges, for the .full file
+};
+
+// catalog_sim reads the ids of the .sim file and numbers them (ids
+// holds the .ind file), translate_sim then writes the .full graph and
+// adds its edges to rows, and truncate_rows writes the .int graph
+void catalog_sim ( string sim_file, int num_threads, IdCatalog &id_catalog,
+                   vector<SimChunk> &chunks, vector<string_view> &ids );
+void translate_sim ( string sim_file, int num_threads, IdCatalog &id_catalog,
+                     vector<SimChunk> &chunks, EdgeWriter &full, EdgeRuns &rows );
+void get_denoms ( EdgeRuns &rows, vector <float> &denom_sims );
+void truncate_rows ( EdgeRuns &rows, EdgeWriter &out, int topn, int num_threads,
+                     vector <float> &denom_sims );
+
+#endif
@@ -35,13 +35,21 @@ void parse::print_syntax( const char *error_string )
 	   << "equivalents, and weights <=0 are screened out." << endl << endl
 	   << "Finally, the .int file has the same format as the .full file, but contains" << endl
 	   << "the truncated version (top n links) for use by layout." << endl << endl
+	   << "With -b the .full and .int files are written in binary form (see" << endl
+	   << "convert_edges), which the other tools read without parsing." << endl << endl
 	   << "OPTIONS" << endl
 	   << "-------" << endl
-	   << "\t-m : Number of times to scan .sim file >= 1." << endl
+	   << "\t-m : Divide the memory used to sort the .full file by m >= 1" << endl
+	   << "\t     (.full files of more than SORT_RUN_EDGES/m edges are sorted" << endl
+	   << "\t     in runs on disk, in temporary files root_file.int.run0," << endl
+	   << "\t     root_file.int.run1, ... which are removed when truncate ends)." << endl
 	   << "\t-n : Normalize output to .int file." << endl
 	   << "\t-t top_n : Truncate .sim file using top n links before writing" << endl 
 	   << "\t           to .int file >= 1 (default 10)." << endl
-       << "\t-r : read a .coord file and create a .real file." << endl << endl;    
+       << "\t-r : read a .coord file and create a .real file." << endl
+	   << "\t-b : write binary .full and .int files." << endl
+	   << "\t-p threads : read the .sim file and select the top n links with" << endl
+	   << "\t             this many threads >= 1 (default 1)." << endl << endl;    
     exit(1);
 }
 
@@ -61,6 +69,8 @@ parse::parse ( int argc, char** argv)
   topn = 10;
   normalize = false;
   real_out = false;
+  binary = false;
+  num_threads = 1;
   
   // now check for optional arguments
   string arg;
@@ -96,11 +106,27 @@ parse::parse ( int argc, char** argv)
 		}
 	}
 	
+	// check for threads
+	else if ( arg == "-p" )
+	{
+		i++;
+		if ( i >= (argc-1) )
+			print_syntax ( "-p flag has no argument." );
+		else
+		{
+			num_threads = atoi ( argv[i] );
+			if ( num_threads < 1 )
+				print_syntax ( "number of threads must be >= 1." );
+		}
+	}
+	
     // check for normalized output
     else if ( arg == "-n" )
 	    normalize = true;
 	else if ( arg == "-r" )
 	    real_out = true;
+	else if ( arg == "-b" )
+	    binary = true;
     else
         print_syntax ( "unrecongized option!" );
   }
@@ -126,6 +152,8 @@ parse::parse ( int argc, char** argv)
   // echo arguments input or default
   cout << "Using memory = " << memory_use << endl
        << "      topn = " << topn << endl
-	   << "      normalize = " << normalize << endl;
+	   << "      normalize = " << normalize << endl
+	   << "      binary = " << binary << endl
+	   << "      threads = " << num_threads << endl;
 
 }
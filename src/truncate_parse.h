@@ -23,10 +23,12 @@ public:
     string coord_file;		// .coord file (output)
 	string real_file;		// .real file (output)
 	
-	int memory_use;         // scan files this many times
+	int memory_use;         // divide sort memory by this
 	int topn;	            // number of shortest links to keep
 	bool normalize;		    // true to produce normalized output
     bool real_out;			// true to produce .real output
+	bool binary;			// true to write binary .full and .int
+	int num_threads;		// threads reading and truncating, int >= 1
 	
 private:
 